@@ -0,0 +1,206 @@
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+
+#include "mock_hal.h"
+#include "hardware/adc.h"
+#include "hardware/i2c.h"
+
+#include "display_controller/display_controller.h"
+#include "display_controller/text_layout.h"
+#include "sensors/thermistor.h"
+#include "sensors/fuel_gauge.h"
+#include "charging_protocols/quick_charge.h"
+
+// repetitions of cheap & expensive cases, enough to keep timer noise under 1%
+#define BENCH_FAST_ITERATIONS 1000000
+#define BENCH_SLOW_ITERATIONS 2000
+
+using namespace display_controller;
+
+namespace {
+    /// @brief results are summed here, so the compiler can't drop the measured work
+    volatile int64_t sink;
+
+    /// @brief time `iterations` calls of fn and print one row of the report
+    /// @param bytes bytes sent over mock i2c by all iterations, 0 if not relevant
+    template <typename F>
+    void measure(const char* name, uint32_t iterations, F&& fn) {
+        mock::reset_i2c_counters();
+
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < iterations; i++) {
+            fn(i);
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        double ns = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+        double bytes = (double)mock::get_i2c_bytes() / iterations;
+        printf("%-40s %10lu %12.1f %10.1f\n", name, (unsigned long)iterations, ns, bytes);
+    }
+
+    void bench_thermistor() {
+        sensors::Thermistor thermistor(26, 0, 100000, 100000, 3950);
+        thermistor.set_lookup(sensors::ThermistorTable<100000, 100000, 3950>::centi_celsius);
+
+        // sweep whole ADC range, so every table segment is hit
+        measure("Thermistor::get", BENCH_FAST_ITERATIONS, [&](uint32_t i) {
+            mock::set_adc(0, (i * 7) & 0xFFF);
+            sink += (int64_t)thermistor.get();
+        });
+        measure("Thermistor::get_centi", BENCH_FAST_ITERATIONS, [&](uint32_t i) {
+            mock::set_adc(0, (i * 7) & 0xFFF);
+            sink += thermistor.get_centi();
+        });
+        measure("Thermistor::get_average_centi", BENCH_FAST_ITERATIONS, [&](uint32_t i) {
+            mock::set_adc(0, (i * 7) & 0xFFF);
+            sink += thermistor.get_average_centi();
+        });
+    }
+
+    void bench_fuel_gauge() {
+        // discharging pack on separate current & voltage inputs, one update per battery task period
+        mock::set_adc(1, 2048 + 400);
+        mock::set_adc(2, 2850);
+        sensors::AdcSampler sampler((1 << 1) | (1 << 2), 1000);
+        sampler.start();
+        sensors::FuelGauge gauge(&sampler, 1000, { 5000, 3, 1, 2, 0, 2048, 5000, 4028, 50, 600000000u });
+        gauge.begin(0);
+        measure("FuelGauge::update", BENCH_FAST_ITERATIONS, [&](uint32_t i) {
+            gauge.update((uint64_t)(i + 1) * 20000);
+            sink += gauge.get_percentage();
+        });
+        sampler.stop();
+    }
+
+    void bench_text() {
+        // longest details that still fit on the screen
+        const char* details = " aslk dj lk jaeioj apr3 98r p;iha jksdh 7hcj ,zn mxb3hb ";
+        LineSpan lines[DISPLAY_MSG_MAX_LINES];
+
+        measure("wrap_lines", BENCH_FAST_ITERATIONS, [&](uint32_t) {
+            sink += wrap_lines(details, DISPLAY_MSG_LINE_WIDTH, lines, DISPLAY_MSG_MAX_LINES);
+        });
+    }
+
+    void bench_text_rendering() {
+        FrameBuffer frame;
+
+        // deg90 goes through pre-rotated atlases, deg0 is still drawn pixel by pixel
+        measure("FrameBuffer::draw_text 16x32 deg90", BENCH_SLOW_ITERATIONS * 10, [&](uint32_t i) {
+            frame.draw_text(font_16x32, "100", 0, i & 7, pico_ssd1306::WriteMode::INVERT, pico_ssd1306::Rotation::deg90);
+        });
+        measure("FrameBuffer::draw_text 16x32 deg0", BENCH_SLOW_ITERATIONS * 10, [&](uint32_t i) {
+            frame.draw_text(font_16x32, "100", 0, i & 7, pico_ssd1306::WriteMode::INVERT, pico_ssd1306::Rotation::deg0);
+        });
+        measure("FrameBuffer::draw_text 5x8 deg90", BENCH_SLOW_ITERATIONS * 10, [&](uint32_t i) {
+            frame.draw_text(font_5x8, "QC_Var", 64, i & 7, pico_ssd1306::WriteMode::INVERT, pico_ssd1306::Rotation::deg90);
+        });
+        measure("FrameBuffer::draw_text 5x8 deg0", BENCH_SLOW_ITERATIONS * 10, [&](uint32_t i) {
+            frame.draw_text(font_5x8, "QC_Var", 64, i & 7, pico_ssd1306::WriteMode::INVERT, pico_ssd1306::Rotation::deg0);
+        });
+        sink += frame.page_data(0)[0];
+    }
+
+    void bench_quick_charge() {
+        charging_protocols::SioDataLines<10, 11, 8, 9> lines;
+        charging_protocols::QuickChargePort_alt port(&lines);
+
+        // grid over 0-3.6V on both lines, 0.1V apart
+        measure("QuickChargePort_alt::mode_from_voltage", BENCH_FAST_ITERATIONS, [&](uint32_t i) {
+            float dp_volts = (i % 37) * .1f;
+            float dm_volts = (i / 37 % 37) * .1f;
+            sink += (int)port.mode_from_voltage(dp_volts, dm_volts);
+        });
+
+        // one output port poll worth of work, sink steps through modes every 64 samples
+        charging_protocols::QcSinkDetector detector(QC_T_GLITCH_BC_DONE_MS * 1000, QC_T_GLITCH_V_CHANGE_MIN_MS * 1000);
+        const uint16_t dp_steps[] = { 600, 3300, 600, 3300, 600 };
+        const uint16_t dm_steps[] = { 0, 600, 600, 3300, 3300 };
+        measure("QcSinkDetector::update", BENCH_FAST_ITERATIONS, [&](uint32_t i) {
+            uint8_t step = (i >> 6) % 5;
+            sink += detector.update(dp_steps[step], dm_steps[step], (uint64_t)i * 1000);
+        });
+    }
+
+    void bench_display() {
+        i2c_init(i2c0, 1000000);
+        mock::reset_i2c_counters();
+        pico_ssd1306::SSD1306 driver(i2c0, MOCK_SSD1306_ADDRESS, pico_ssd1306::Size::W128xH64);
+        printf("%-40s %10s %12s %10lu\n", "SSD1306 init", "1", "-", (unsigned long)mock::get_i2c_bytes());
+
+        Display display(&driver, i2c0, MOCK_SSD1306_ADDRESS, 5);
+
+        using charging_protocols::PortState;
+        const PortState even[] = {
+            { 5000, ChargingModes::GEN_5v, 0, 0 },
+            { 5000, ChargingModes::QC_5v, 1, 0 },
+            { 5000, ChargingModes::PD_5v, 0, 0 },
+        };
+        const PortState odd_states[] = {
+            { 11800, ChargingModes::QC_Var, 1, 0 },
+            { 12000, ChargingModes::QC_12v, 1, 0 },
+            { 20000, ChargingModes::PD_20v, 0, 0 },
+        };
+        auto update_ports = [&](const PortState* states) {
+            for (uint8_t port = 0; port < DISPLAY_PORT_COUNT; port++) {
+                display.update_port(port, states[port]);
+            }
+        };
+
+        // GDDRAM content is unknown at first, so the first frame is sent whole
+        measure("main menu, first frame", 1, [&](uint32_t) {
+            display.main_menu();
+            update_ports(even);
+            display.update_battery(0);
+            sink += display.flush();
+        });
+
+        // alternating between two screens, every frame really changes pixels
+        measure("main menu redraw", BENCH_SLOW_ITERATIONS, [&](uint32_t i) {
+            bool odd = i & 1;
+            update_ports(odd ? odd_states : even);
+            display.update_battery(odd ? 100 : 0);
+            display.main_menu();
+            sink += display.flush();
+        });
+
+        // panel already shows the same pixels, nothing should reach the bus
+        measure("main menu redraw, unchanged", BENCH_SLOW_ITERATIONS, [&](uint32_t) {
+            display.main_menu();
+            update_ports(odd_states);
+            display.update_battery(100);
+            sink += display.flush();
+        });
+
+        // steady state: same snapshots keep coming, no widget is redrawn
+        measure("port & battery update, unchanged", BENCH_FAST_ITERATIONS, [&](uint32_t) {
+            update_ports(odd_states);
+            display.update_battery(100);
+            sink += display.flush();
+        });
+
+        measure("port update", BENCH_SLOW_ITERATIONS, [&](uint32_t i) {
+            update_ports(i & 1 ? odd_states : even);
+            sink += display.flush();
+        });
+
+        measure("battery update", BENCH_SLOW_ITERATIONS, [&](uint32_t i) {
+            display.update_battery(i % 101);
+            sink += display.flush();
+        });
+    }
+}
+
+int main() {
+    adc_init();
+
+    printf("%-40s %10s %12s %10s\n", "benchmark", "iterations", "ns/op", "i2c B/op");
+    bench_thermistor();
+    bench_fuel_gauge();
+    bench_text();
+    bench_text_rendering();
+    bench_quick_charge();
+    bench_display();
+    return 0;
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include "pico/stdlib.h"
+
+enum clock_index {
+    clk_gpout0 = 0,
+    clk_gpout1,
+    clk_gpout2,
+    clk_gpout3,
+    clk_ref,
+    clk_sys,
+    clk_peri,
+    clk_usb,
+    clk_adc,
+    clk_rtc,
+    CLK_COUNT
+};
+
+// default clk_sys of the RP2040
+#define MOCK_CLK_SYS_HZ 125000000
+
+uint32_t clock_get_hz(enum clock_index clk_index);
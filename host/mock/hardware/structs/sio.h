@@ -0,0 +1,24 @@
+#pragma once
+#include "pico/stdlib.h"
+
+/// @brief SIO GPIO register, reads & writes go to the mock pins so gpio_* calls and direct access agree
+struct mock_sio_register {
+    uint8_t reg;
+    operator uint32_t() const volatile;
+    void operator=(uint32_t value) volatile;
+};
+
+// the only field the firmware reads is the register name, layout of the RP2040 block isn't kept
+typedef struct {
+    volatile mock_sio_register gpio_in;
+    volatile mock_sio_register gpio_out;
+    volatile mock_sio_register gpio_set;
+    volatile mock_sio_register gpio_clr;
+    volatile mock_sio_register gpio_togl;
+    volatile mock_sio_register gpio_oe;
+    volatile mock_sio_register gpio_oe_set;
+    volatile mock_sio_register gpio_oe_clr;
+    volatile mock_sio_register gpio_oe_togl;
+} sio_hw_t;
+
+extern sio_hw_t* sio_hw;
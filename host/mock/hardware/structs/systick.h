@@ -0,0 +1,17 @@
+#pragma once
+#include "pico/stdlib.h"
+
+/// @brief SysTick current value, counts down at MOCK_CLK_SYS_HZ from the host clock, a write restarts it
+struct mock_systick_counter {
+    operator uint32_t() const volatile;
+    void operator=(uint32_t value) volatile;
+};
+
+typedef struct {
+    volatile uint32_t csr;
+    volatile uint32_t rvr;
+    volatile mock_systick_counter cvr;
+    volatile uint32_t calib;
+} systick_hw_t;
+
+extern systick_hw_t* systick_hw;
@@ -0,0 +1,13 @@
+#pragma once
+#include "pico/stdlib.h"
+
+/// @brief registers of the watchdog, scratch ones are plain memory on the host
+typedef struct {
+    volatile uint32_t ctrl;
+    volatile uint32_t load;
+    volatile uint32_t reason;
+    volatile uint32_t scratch[8];
+    volatile uint32_t tick;
+} watchdog_hw_t;
+
+extern watchdog_hw_t* watchdog_hw;
@@ -0,0 +1,14 @@
+#pragma once
+#include "pico/stdlib.h"
+
+typedef struct uart_inst uart_inst_t;
+extern uart_inst_t uart0_inst;
+extern uart_inst_t uart1_inst;
+#define uart0 (&uart0_inst)
+#define uart1 (&uart1_inst)
+
+#define PICO_DEFAULT_UART_BAUD_RATE 115200
+
+uint uart_set_baudrate(uart_inst_t* uart, uint baudrate);
+bool uart_is_writable(uart_inst_t* uart);
+void uart_putc_raw(uart_inst_t* uart, char c);
@@ -0,0 +1,7 @@
+#pragma once
+#include "pico/stdlib.h"
+#include "hardware/structs/watchdog.h"
+
+bool watchdog_caused_reboot();
+void watchdog_enable(uint32_t delay_ms, bool pause_on_debug);
+void watchdog_update();
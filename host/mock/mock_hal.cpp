@@ -0,0 +1,676 @@
+#include "mock_hal.h"
+
+#include <chrono>
+#include <deque>
+#include <thread>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hardware/i2c.h"
+#include "hardware/adc.h"
+#include "hardware/dma.h"
+#include "hardware/uart.h"
+#include "hardware/watchdog.h"
+#include "hardware/flash.h"
+#include "hardware/sync.h"
+#include "hardware/clocks.h"
+#include "hardware/structs/systick.h"
+#include "hardware/structs/sio.h"
+#include "hardware/structs/watchdog.h"
+#include "pico/multicore.h"
+#include "pico/stdio_usb.h"
+#include "pico/stdio_uart.h"
+#include "tusb.h"
+
+#define MOCK_GPIO_COUNT 30
+#define MOCK_ADC_INPUTS 5
+
+// layout of dma_channel_config::ctrl in the mock, it isn't the RP2040 CTRL register
+#define CONFIG_SIZE_MASK        0x3u
+#define CONFIG_READ_INCR        (1u << 2)
+#define CONFIG_WRITE_INCR       (1u << 3)
+#define CONFIG_DREQ_SHIFT       8
+#define CONFIG_DREQ_MASK        (0x3Fu << CONFIG_DREQ_SHIFT)
+#define CONFIG_CHAIN_SHIFT      16
+#define CONFIG_CHAIN_MASK       (0xFu << CONFIG_CHAIN_SHIFT)
+
+namespace {
+    // ---- time ----
+    const std::chrono::steady_clock::time_point boot = std::chrono::steady_clock::now();
+
+    // ---- gpio ----
+    struct Pin {
+        bool output;
+        bool level;
+        bool input;
+        bool input_set;
+        bool pull_up;
+        uint32_t irq_events;
+    };
+    Pin pins[MOCK_GPIO_COUNT];
+    gpio_irq_callback_t gpio_callback = nullptr;
+
+    // ---- clocks ----
+    uint32_t clk_sys_hz = MOCK_CLK_SYS_HZ;
+
+    // ---- i2c ----
+    i2c_hw_t i2c0_regs = { 0, 0, 0, 0, 0, I2C_IC_STATUS_TFE_BITS };
+    i2c_hw_t i2c1_regs = { 0, 0, 0, 0, 0, I2C_IC_STATUS_TFE_BITS };
+    bool in_transaction[2];
+    uint64_t i2c_bytes = 0;
+    uint64_t i2c_transactions = 0;
+
+    mock::Ssd1306Model& model() {
+        static mock::Ssd1306Model instance;
+        return instance;
+    }
+
+    /// @brief byte on the wire, `address` is the one set when the transaction started
+    void i2c_byte(uint index, uint8_t address, uint8_t byte, bool stop) {
+        bool to_panel = index == 0 && address == MOCK_SSD1306_ADDRESS;
+
+        if (!in_transaction[index]) {
+            in_transaction[index] = true;
+            i2c_transactions++;
+            if (to_panel) { model().begin(); }
+        }
+
+        i2c_bytes++;
+        if (to_panel) { model().write(byte); }
+
+        if (stop) {
+            in_transaction[index] = false;
+            if (to_panel) { model().end(); }
+        }
+    }
+
+    // ---- adc ----
+    adc_hw_t adc_regs;
+    uint16_t adc_values[MOCK_ADC_INPUTS];
+    uint adc_selected = 0;
+    uint adc_round_robin = 0;
+
+    /// @brief next conversion the free running ADC would make
+    uint16_t adc_convert() {
+        uint16_t value = adc_values[adc_selected];
+        if (adc_round_robin != 0) {
+            do {
+                adc_selected = (adc_selected + 1) % MOCK_ADC_INPUTS;
+            } while (!(adc_round_robin >> adc_selected & 1));
+        }
+        return value;
+    }
+
+    // ---- dma ----
+    dma_hw_t dma_regs;
+    dma_channel_config dma_configs[NUM_DMA_CHANNELS];
+    bool dma_claimed[NUM_DMA_CHANNELS];
+
+    uint32_t read_item(uintptr_t address, uint size) {
+        if (size == 1) { return *(const volatile uint8_t*)address; }
+        if (size == 2) { return *(const volatile uint16_t*)address; }
+        return *(const volatile uint32_t*)address;
+    }
+
+    void write_item(uintptr_t address, uint size, uint32_t value) {
+        if (size == 1) { *(volatile uint8_t*)address = value; }
+        else if (size == 2) { *(volatile uint16_t*)address = value; }
+        else { *(volatile uint32_t*)address = value; }
+    }
+
+    /// @brief run whole transfer at once; DREQ pacing & chaining aren't modelled,
+    /// so an ADC ring is filled once and never wraps
+    void dma_run(uint channel) {
+        dma_channel_hw_t& ch = dma_regs.ch[channel];
+        uint32_t ctrl = dma_configs[channel].ctrl;
+        uint size = 1u << (ctrl & CONFIG_SIZE_MASK);
+        bool read_incr = ctrl & CONFIG_READ_INCR;
+        bool write_incr = ctrl & CONFIG_WRITE_INCR;
+
+        uintptr_t read = ch.read_addr;
+        uintptr_t write = ch.write_addr;
+
+        int i2c_index = -1;
+        if (write == (uintptr_t)&i2c0_regs.data_cmd) { i2c_index = 0; }
+        if (write == (uintptr_t)&i2c1_regs.data_cmd) { i2c_index = 1; }
+        bool from_adc = read == (uintptr_t)&adc_regs.fifo;
+
+        for (uint32_t n = 0; n < ch.transfer_count; n++) {
+            uint32_t value = from_adc ? adc_convert() : read_item(read, size);
+
+            if (i2c_index >= 0) {
+                i2c_hw_t& regs = i2c_index == 0 ? i2c0_regs : i2c1_regs;
+                i2c_byte(i2c_index, regs.tar, value & 0xFF, value & I2C_IC_DATA_CMD_STOP_BITS);
+            }
+            else {
+                write_item(write, size, value);
+            }
+
+            if (read_incr) { read += size; }
+            if (write_incr) { write += size; }
+        }
+
+        ch.read_addr = read;
+        ch.write_addr = write;
+        ch.transfer_count = 0;
+    }
+
+    // ---- uart ----
+    std::vector<uint8_t> uart_output;
+
+    // ---- usb ----
+    bool usb_connected = false;
+    uint32_t usb_write_available = 0;
+    std::vector<uint8_t> usb_output;
+
+    // ---- multicore ----
+    std::deque<uint32_t> fifo;
+
+    // ---- flash ----
+    uint32_t flash_erases[PICO_FLASH_SIZE_BYTES / FLASH_SECTOR_SIZE];
+
+    // ---- watchdog ----
+    watchdog_hw_t watchdog_regs;
+
+    // ---- systick ----
+    systick_hw_t systick_regs;
+    std::chrono::steady_clock::time_point systick_start = boot;
+
+    // ---- sio ----
+    enum SioRegister : uint8_t { SIO_IN, SIO_OUT, SIO_SET, SIO_CLR, SIO_TOGL, SIO_OE, SIO_OE_SET, SIO_OE_CLR, SIO_OE_TOGL };
+    sio_hw_t sio_regs = {
+        { SIO_IN }, { SIO_OUT }, { SIO_SET }, { SIO_CLR }, { SIO_TOGL },
+        { SIO_OE }, { SIO_OE_SET }, { SIO_OE_CLR }, { SIO_OE_TOGL }
+    };
+}
+
+i2c_inst_t i2c0_inst = { &i2c0_regs, false };
+i2c_inst_t i2c1_inst = { &i2c1_regs, false };
+
+adc_hw_t* adc_hw = &adc_regs;
+systick_hw_t* systick_hw = &systick_regs;
+watchdog_hw_t* watchdog_hw = &watchdog_regs;
+sio_hw_t* sio_hw = &sio_regs;
+dma_hw_t* dma_hw = &dma_regs;
+
+struct uart_inst {
+    int index;
+};
+uart_inst_t uart0_inst = { 0 };
+uart_inst_t uart1_inst = { 1 };
+
+// ---- mock control ----
+
+mock::Ssd1306Model& mock::panel() {
+    return model();
+}
+
+uint64_t mock::get_i2c_bytes() {
+    return i2c_bytes;
+}
+
+uint64_t mock::get_i2c_transactions() {
+    return i2c_transactions;
+}
+
+void mock::reset_i2c_counters() {
+    i2c_bytes = 0;
+    i2c_transactions = 0;
+    model().reset_counters();
+}
+
+void mock::set_adc(uint8_t input, uint16_t raw) {
+    if (input < MOCK_ADC_INPUTS) { adc_values[input] = raw & 0xFFF; }
+}
+
+void mock::set_gpio_input(uint gpio, bool level) {
+    if (gpio >= MOCK_GPIO_COUNT) { return; }
+    bool previous = gpio_get(gpio);
+    pins[gpio].input = level;
+    pins[gpio].input_set = true;
+
+    uint32_t event = 0;
+    if (previous && !gpio_get(gpio)) { event = GPIO_IRQ_EDGE_FALL; }
+    if (!previous && gpio_get(gpio)) { event = GPIO_IRQ_EDGE_RISE; }
+    if ((pins[gpio].irq_events & event) && gpio_callback != nullptr) {
+        gpio_callback(gpio, event);
+    }
+}
+
+const std::vector<uint8_t>& mock::get_uart_output() {
+    return uart_output;
+}
+
+void mock::clear_uart_output() {
+    uart_output.clear();
+}
+
+void mock::set_usb(bool connected, uint32_t write_available) {
+    usb_connected = connected;
+    usb_write_available = write_available;
+}
+
+const std::vector<uint8_t>& mock::get_usb_output() {
+    return usb_output;
+}
+
+void mock::clear_usb_output() {
+    usb_output.clear();
+}
+
+uint32_t mock::get_flash_erases(uint32_t sector) {
+    return sector < PICO_FLASH_SIZE_BYTES / FLASH_SECTOR_SIZE ? flash_erases[sector] : 0;
+}
+
+// ---- time ----
+
+uint64_t time_us_64() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - boot).count();
+}
+
+uint32_t time_us_32() {
+    return (uint32_t)time_us_64();
+}
+
+void sleep_ms(uint32_t ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void sleep_us(uint64_t us) {
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+bool best_effort_wfe_or_timeout(absolute_time_t timeout_timestamp) {
+    uint64_t now = time_us_64();
+    if (timeout_timestamp > now) { sleep_us(timeout_timestamp - now); }
+    return true;
+}
+
+bool set_sys_clock_khz(uint32_t freq_khz, bool) {
+    clk_sys_hz = freq_khz * 1000;
+    return true;
+}
+
+void busy_wait_us_32(uint32_t us) {
+    uint64_t end = time_us_64() + us;
+    while (time_us_64() < end) {}
+}
+
+bool stdio_init_all() {
+    return true;
+}
+
+int getchar_timeout_us(uint32_t) {
+    return PICO_ERROR_TIMEOUT;
+}
+
+// ---- usb ----
+
+static void usb_out_chars(const char* buf, int len) {
+    if (!usb_connected) { return; }
+    uint32_t length = (uint32_t)len < usb_write_available ? len : usb_write_available;
+    usb_output.insert(usb_output.end(), buf, buf + length);
+    usb_write_available -= length;
+}
+
+stdio_driver_t stdio_usb = { usb_out_chars, nullptr, false };
+
+void stdio_set_driver_enabled(stdio_driver_t*, bool) {}
+
+bool tud_cdc_connected() {
+    return usb_connected;
+}
+
+uint32_t tud_cdc_write_available() {
+    return usb_connected ? usb_write_available : 0;
+}
+
+// ---- clocks ----
+
+uint32_t clock_get_hz(enum clock_index clk_index) {
+    return clk_index == clk_sys ? clk_sys_hz : 0;
+}
+
+mock_systick_counter::operator uint32_t() const volatile {
+    uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - systick_start).count();
+    uint64_t cycles = ns * (MOCK_CLK_SYS_HZ / 1000000) / 1000;
+    uint32_t reload = systick_regs.rvr + 1;
+    return reload - 1 - cycles % reload;
+}
+
+void mock_systick_counter::operator=(uint32_t) volatile {
+    systick_start = std::chrono::steady_clock::now();
+}
+
+// ---- sio ----
+
+mock_sio_register::operator uint32_t() const volatile {
+    uint32_t value = 0;
+    for (uint gpio = 0; gpio < MOCK_GPIO_COUNT; gpio++) {
+        bool bit = false;
+        switch (reg) {
+        case SIO_IN: bit = gpio_get(gpio); break;
+        case SIO_OUT: bit = pins[gpio].level; break;
+        case SIO_OE: bit = pins[gpio].output; break;
+        default: break;                     // set/clr/togl aliases read as 0
+        }
+        value |= (uint32_t)bit << gpio;
+    }
+    return value;
+}
+
+void mock_sio_register::operator=(uint32_t value) volatile {
+    for (uint gpio = 0; gpio < MOCK_GPIO_COUNT; gpio++) {
+        bool bit = value & (1u << gpio);
+        Pin& pin = pins[gpio];
+        switch (reg) {
+        case SIO_OUT: pin.level = bit; break;
+        case SIO_SET: pin.level |= bit; break;
+        case SIO_CLR: pin.level &= !bit; break;
+        case SIO_TOGL: pin.level ^= bit; break;
+        case SIO_OE: pin.output = bit; break;
+        case SIO_OE_SET: pin.output |= bit; break;
+        case SIO_OE_CLR: pin.output &= !bit; break;
+        case SIO_OE_TOGL: pin.output ^= bit; break;
+        default: break;                     // inputs are read only
+        }
+    }
+}
+
+// ---- gpio ----
+
+void gpio_init(uint gpio) {
+    if (gpio >= MOCK_GPIO_COUNT) { return; }
+    pins[gpio].output = false;
+    pins[gpio].level = false;
+}
+
+void gpio_set_function(uint, enum gpio_function) {}
+
+void gpio_set_irq_enabled_with_callback(uint gpio, uint32_t event_mask, bool enabled, gpio_irq_callback_t callback) {
+    if (gpio >= MOCK_GPIO_COUNT) { return; }
+    if (enabled) { pins[gpio].irq_events |= event_mask; }
+    else { pins[gpio].irq_events &= ~event_mask; }
+    gpio_callback = callback;
+}
+
+void gpio_set_dir(uint gpio, bool out) {
+    if (gpio < MOCK_GPIO_COUNT) { pins[gpio].output = out; }
+}
+
+void gpio_put(uint gpio, bool value) {
+    if (gpio < MOCK_GPIO_COUNT) { pins[gpio].level = value; }
+}
+
+bool gpio_get(uint gpio) {
+    if (gpio >= MOCK_GPIO_COUNT) { return false; }
+    const Pin& pin = pins[gpio];
+    if (pin.output) { return pin.level; }
+    if (pin.input_set) { return pin.input; }
+    return pin.pull_up;
+}
+
+void gpio_pull_up(uint gpio) {
+    if (gpio < MOCK_GPIO_COUNT) { pins[gpio].pull_up = true; }
+}
+
+void gpio_pull_down(uint gpio) {
+    if (gpio < MOCK_GPIO_COUNT) { pins[gpio].pull_up = false; }
+}
+
+void gpio_disable_pulls(uint gpio) {
+    if (gpio < MOCK_GPIO_COUNT) { pins[gpio].pull_up = false; }
+}
+
+// ---- i2c ----
+
+uint i2c_init(i2c_inst_t*, uint baudrate) {
+    return baudrate;
+}
+
+uint i2c_set_baudrate(i2c_inst_t*, uint baudrate) {
+    return baudrate;
+}
+
+int i2c_write_blocking(i2c_inst_t* i2c, uint8_t addr, const uint8_t* src, size_t len, bool nostop) {
+    uint index = i2c_hw_index(i2c);
+    for (size_t n = 0; n < len; n++) {
+        i2c_byte(index, addr, src[n], !nostop && n == len - 1);
+    }
+    return len;
+}
+
+// ---- adc ----
+
+void adc_init() {
+    memset(&adc_regs, 0, sizeof(adc_regs));
+    adc_selected = 0;
+    adc_round_robin = 0;
+}
+
+void adc_gpio_init(uint gpio) {
+    gpio_init(gpio);
+}
+
+void adc_select_input(uint input) {
+    if (input < MOCK_ADC_INPUTS) { adc_selected = input; }
+}
+
+uint adc_get_selected_input() {
+    return adc_selected;
+}
+
+uint16_t adc_read() {
+    return adc_values[adc_selected];
+}
+
+void adc_set_temp_sensor_enabled(bool) {}
+
+void adc_set_clkdiv(float clkdiv) {
+    adc_regs.div = (uint32_t)(clkdiv * 256);
+}
+
+void adc_set_round_robin(uint input_mask) {
+    adc_round_robin = input_mask & ((1 << MOCK_ADC_INPUTS) - 1);
+}
+
+void adc_fifo_setup(bool, bool, uint16_t, bool, bool) {}
+
+void adc_fifo_drain() {}
+
+void adc_run(bool) {}
+
+// ---- dma ----
+
+int dma_claim_unused_channel(bool required) {
+    for (uint channel = 0; channel < NUM_DMA_CHANNELS; channel++) {
+        if (!dma_claimed[channel]) {
+            dma_claimed[channel] = true;
+            return channel;
+        }
+    }
+    if (required) {
+        fprintf(stderr, "mock: no free DMA channel\n");
+        abort();
+    }
+    return -1;
+}
+
+void dma_channel_unclaim(uint channel) {
+    dma_claimed[channel] = false;
+}
+
+dma_channel_config dma_channel_get_default_config(uint channel) {
+    dma_channel_config config;
+    config.ctrl = DMA_SIZE_32 | CONFIG_READ_INCR | (DREQ_FORCE << CONFIG_DREQ_SHIFT) | (channel << CONFIG_CHAIN_SHIFT);
+    return config;
+}
+
+void channel_config_set_transfer_data_size(dma_channel_config* c, enum dma_channel_transfer_size size) {
+    c->ctrl = (c->ctrl & ~CONFIG_SIZE_MASK) | size;
+}
+
+void channel_config_set_read_increment(dma_channel_config* c, bool incr) {
+    c->ctrl = incr ? c->ctrl | CONFIG_READ_INCR : c->ctrl & ~CONFIG_READ_INCR;
+}
+
+void channel_config_set_write_increment(dma_channel_config* c, bool incr) {
+    c->ctrl = incr ? c->ctrl | CONFIG_WRITE_INCR : c->ctrl & ~CONFIG_WRITE_INCR;
+}
+
+void channel_config_set_dreq(dma_channel_config* c, uint dreq) {
+    c->ctrl = (c->ctrl & ~CONFIG_DREQ_MASK) | (dreq << CONFIG_DREQ_SHIFT);
+}
+
+void channel_config_set_chain_to(dma_channel_config* c, uint chain_to) {
+    c->ctrl = (c->ctrl & ~CONFIG_CHAIN_MASK) | (chain_to << CONFIG_CHAIN_SHIFT);
+}
+
+void channel_config_set_ring(dma_channel_config*, bool, uint) {}
+
+void dma_channel_configure(uint channel, const dma_channel_config* config, volatile void* write_addr,
+    const volatile void* read_addr, uint transfer_count, bool trigger) {
+    dma_configs[channel] = *config;
+    dma_regs.ch[channel].write_addr = (uintptr_t)write_addr;
+    dma_regs.ch[channel].read_addr = (uintptr_t)read_addr;
+    dma_regs.ch[channel].transfer_count = transfer_count;
+    if (trigger) { dma_run(channel); }
+}
+
+void dma_channel_transfer_from_buffer_now(uint channel, const volatile void* read_addr, uint32_t transfer_count) {
+    dma_regs.ch[channel].read_addr = (uintptr_t)read_addr;
+    dma_regs.ch[channel].transfer_count = transfer_count;
+    dma_run(channel);
+}
+
+void dma_channel_transfer_to_buffer_now(uint channel, volatile void* write_addr, uint32_t transfer_count) {
+    dma_regs.ch[channel].write_addr = (uintptr_t)write_addr;
+    dma_regs.ch[channel].transfer_count = transfer_count;
+    dma_run(channel);
+}
+
+void dma_channel_start(uint channel) {
+    dma_run(channel);
+}
+
+void dma_channel_abort(uint channel) {
+    dma_regs.ch[channel].transfer_count = 0;
+}
+
+bool dma_channel_is_busy(uint) {
+    return false;
+}
+
+void dma_channel_wait_for_finish_blocking(uint) {}
+
+// ---- uart ----
+
+uint uart_set_baudrate(uart_inst_t*, uint baudrate) {
+    return baudrate;
+}
+
+bool uart_is_writable(uart_inst_t*) {
+    return true;
+}
+
+void uart_putc_raw(uart_inst_t*, char c) {
+    uart_output.push_back((uint8_t)c);
+}
+
+static void uart_out_chars(const char* buf, int len) {
+    uart_output.insert(uart_output.end(), buf, buf + len);
+}
+
+static int uart_in_chars(char*, int) {
+    return PICO_ERROR_TIMEOUT;
+}
+
+stdio_driver_t stdio_uart = { uart_out_chars, uart_in_chars, true };
+
+// ---- watchdog ----
+
+bool watchdog_caused_reboot() {
+    return false;
+}
+
+void watchdog_enable(uint32_t, bool) {}
+
+void watchdog_update() {}
+
+// ---- flash ----
+
+uint8_t mock_flash[PICO_FLASH_SIZE_BYTES];
+
+namespace {
+    // erased chip, as it comes from the factory
+    struct ErasedFlash {
+        ErasedFlash() { memset(mock_flash, 0xFF, sizeof(mock_flash)); }
+    } erased_flash;
+}
+
+void flash_range_erase(uint32_t flash_offs, size_t count) {
+    if (flash_offs % FLASH_SECTOR_SIZE || count % FLASH_SECTOR_SIZE || flash_offs + count > PICO_FLASH_SIZE_BYTES) {
+        fprintf(stderr, "mock: unaligned flash erase range 0x%x+%zu\n", (unsigned)flash_offs, count);
+        abort();
+    }
+    memset(mock_flash + flash_offs, 0xFF, count);
+    for (size_t sector = flash_offs / FLASH_SECTOR_SIZE; sector < (flash_offs + count) / FLASH_SECTOR_SIZE; sector++) {
+        flash_erases[sector]++;
+    }
+}
+
+void flash_range_program(uint32_t flash_offs, const uint8_t* data, size_t count) {
+    if (flash_offs % FLASH_PAGE_SIZE || count % FLASH_PAGE_SIZE || flash_offs + count > PICO_FLASH_SIZE_BYTES) {
+        fprintf(stderr, "mock: unaligned flash program range 0x%x+%zu\n", (unsigned)flash_offs, count);
+        abort();
+    }
+    // NOR flash only clears bits, 0xFF leaves a byte as it was
+    for (size_t i = 0; i < count; i++) {
+        mock_flash[flash_offs + i] &= data[i];
+    }
+}
+
+uint32_t save_and_disable_interrupts() {
+    return 0;
+}
+
+void restore_interrupts(uint32_t) {}
+
+// ---- multicore ----
+
+void multicore_launch_core1(void (*)(void)) {
+    // there's no second core, code meant for it is driven from the benchmark directly
+}
+
+void multicore_reset_core1() {
+    fifo.clear();
+}
+
+void multicore_fifo_push_blocking(uint32_t data) {
+    fifo.push_back(data);
+}
+
+uint32_t multicore_fifo_pop_blocking() {
+    if (fifo.empty()) { return 0; }
+    uint32_t data = fifo.front();
+    fifo.pop_front();
+    return data;
+}
+
+bool multicore_fifo_rvalid() {
+    return !fifo.empty();
+}
+
+bool multicore_fifo_wready() {
+    return true;
+}
+
+void multicore_lockout_victim_init() {}
+
+bool multicore_lockout_victim_is_initialized(uint) {
+    return true;
+}
+
+void multicore_lockout_start_blocking() {}
+
+void multicore_lockout_end_blocking() {}
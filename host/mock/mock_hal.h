@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+#include "pico/stdlib.h"
+#include "ssd1306_model.h"
+
+// i2c address the SSD1306 model answers on
+#define MOCK_SSD1306_ADDRESS 0x3C
+
+/// @brief control & inspection of the host stand-in HAL, used by benchmarks
+namespace mock {
+    /// @brief panel connected to i2c0, it sees writes made with i2c_write_blocking() & DMA
+    Ssd1306Model& panel();
+
+    /// @brief bytes written to any i2c controller, address bytes aren't counted
+    uint64_t get_i2c_bytes();
+
+    /// @brief i2c transactions (START ... STOP) on any controller
+    uint64_t get_i2c_transactions();
+
+    void reset_i2c_counters();
+
+    /// @brief value returned by adc_read() & put into the FIFO for given input
+    void set_adc(uint8_t input, uint16_t raw);
+
+    /// @brief level seen on a pin that isn't an output
+    void set_gpio_input(uint gpio, bool level);
+
+    /// @brief everything written with uart_putc_raw(), e.g. binary log records
+    const std::vector<uint8_t>& get_uart_output();
+
+    void clear_uart_output();
+
+    /// @brief host opening the CDC port & free space in its transmit buffer
+    void set_usb(bool connected, uint32_t write_available);
+
+    /// @brief everything written to the CDC port with stdio_usb
+    const std::vector<uint8_t>& get_usb_output();
+
+    void clear_usb_output();
+
+    /// @brief times a flash sector was erased since start
+    uint32_t get_flash_erases(uint32_t sector);
+}
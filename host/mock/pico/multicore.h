@@ -0,0 +1,14 @@
+#pragma once
+#include "pico/stdlib.h"
+
+// core 1 is not started on the host, launching it is a no-op and parking it always succeeds
+void multicore_launch_core1(void (*entry)(void));
+void multicore_reset_core1();
+void multicore_fifo_push_blocking(uint32_t data);
+uint32_t multicore_fifo_pop_blocking();
+bool multicore_fifo_rvalid();
+bool multicore_fifo_wready();
+void multicore_lockout_victim_init();
+bool multicore_lockout_victim_is_initialized(uint core_num);
+void multicore_lockout_start_blocking();
+void multicore_lockout_end_blocking();
@@ -0,0 +1,13 @@
+#pragma once
+#include "pico/stdlib.h"
+
+#define PICO_STDIO_ENABLE_CRLF_SUPPORT 1
+#define PICO_STDIO_DEFAULT_CRLF 1
+
+typedef struct stdio_driver {
+    void (*out_chars)(const char* buf, int len);
+    int (*in_chars)(char* buf, int len);
+    bool crlf_enabled;
+} stdio_driver_t;
+
+void stdio_set_driver_enabled(stdio_driver_t* driver, bool enabled);
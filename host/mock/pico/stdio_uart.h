@@ -0,0 +1,5 @@
+#pragma once
+#include "pico/stdio.h"
+
+/// @brief writes go to mock::get_uart_output(), console input is never available
+extern stdio_driver_t stdio_uart;
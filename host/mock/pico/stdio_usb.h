@@ -0,0 +1,5 @@
+#pragma once
+#include "pico/stdio.h"
+
+/// @brief writes go to mock::get_usb_output(), only while the port is connected
+extern stdio_driver_t stdio_usb;
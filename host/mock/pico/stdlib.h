@@ -0,0 +1,78 @@
+#pragma once
+// host stand-in for pico-sdk, only what the firmware modules use
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef unsigned int uint;
+
+// ---- time ----
+typedef uint64_t absolute_time_t;
+static inline absolute_time_t from_us_since_boot(uint64_t us) { return us; }
+
+uint64_t time_us_64();
+uint32_t time_us_32();
+void sleep_ms(uint32_t ms);
+void sleep_us(uint64_t us);
+void busy_wait_us_32(uint32_t us);
+static inline void tight_loop_contents() {}
+/// @brief events aren't modelled, host just sleeps until the timeout
+/// @return true if timeout was reached
+bool best_effort_wfe_or_timeout(absolute_time_t timeout_timestamp);
+
+// ---- platform ----
+/// @brief pico-sdk keeps these in release builds as well
+#define hard_assert(condition) do { if (!(condition)) { fprintf(stderr, "hard_assert failed: %s\n", #condition); abort(); } } while (0)
+/// @brief core 1 is never started on the host
+static inline uint get_core_num() { return 0; }
+
+// ---- clocks ----
+/// @brief changes what clock_get_hz(clk_sys) reports
+bool set_sys_clock_khz(uint32_t freq_khz, bool required);
+
+// ---- stdio ----
+#define PICO_ERROR_TIMEOUT -1
+
+bool stdio_init_all();
+/// @brief console input is never available on the host
+int getchar_timeout_us(uint32_t timeout_us);
+
+// ---- gpio ----
+enum gpio_function {
+    GPIO_FUNC_XIP = 0,
+    GPIO_FUNC_SPI = 1,
+    GPIO_FUNC_UART = 2,
+    GPIO_FUNC_I2C = 3,
+    GPIO_FUNC_PWM = 4,
+    GPIO_FUNC_SIO = 5,
+    GPIO_FUNC_PIO0 = 6,
+    GPIO_FUNC_PIO1 = 7,
+    GPIO_FUNC_GPCK = 8,
+    GPIO_FUNC_USB = 9,
+    GPIO_FUNC_NULL = 0x1f,
+};
+
+#define GPIO_OUT 1
+#define GPIO_IN 0
+
+void gpio_init(uint gpio);
+void gpio_set_function(uint gpio, enum gpio_function fn);
+void gpio_set_dir(uint gpio, bool out);
+void gpio_put(uint gpio, bool value);
+bool gpio_get(uint gpio);
+void gpio_pull_up(uint gpio);
+void gpio_pull_down(uint gpio);
+void gpio_disable_pulls(uint gpio);
+
+enum gpio_irq_level {
+    GPIO_IRQ_LEVEL_LOW = 0x1u,
+    GPIO_IRQ_LEVEL_HIGH = 0x2u,
+    GPIO_IRQ_EDGE_FALL = 0x4u,
+    GPIO_IRQ_EDGE_RISE = 0x8u,
+};
+
+typedef void (*gpio_irq_callback_t)(uint gpio, uint32_t event_mask);
+/// @brief edges are raised by mock::set_gpio_input, the callback runs right inside it
+void gpio_set_irq_enabled_with_callback(uint gpio, uint32_t event_mask, bool enabled, gpio_irq_callback_t callback);
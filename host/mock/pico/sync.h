@@ -0,0 +1,10 @@
+#pragma once
+#include "pico/stdlib.h"
+
+typedef struct {
+    int depth;
+} critical_section_t;
+
+static inline void critical_section_init(critical_section_t* cs) { cs->depth = 0; }
+static inline void critical_section_enter_blocking(critical_section_t* cs) { cs->depth++; }
+static inline void critical_section_exit(critical_section_t* cs) { cs->depth--; }
@@ -0,0 +1,164 @@
+#include "ssd1306_model.h"
+
+#include <string.h>
+
+// commands the model acts on, everything else is only parsed
+#define CMD_MEMORY_MODE     0x20
+#define CMD_COLUMN_ADDR     0x21
+#define CMD_PAGE_ADDR       0x22
+#define CMD_CONTRAST        0x81
+#define CMD_DISPLAY_OFF     0xAE
+#define CMD_DISPLAY_ON      0xAF
+
+#define MODE_HORIZONTAL     0
+#define MODE_VERTICAL       1
+#define MODE_PAGE           2
+
+using namespace mock;
+
+Ssd1306Model::Ssd1306Model() {
+    reset();
+}
+
+void Ssd1306Model::reset() {
+    memset(gddram, 0, sizeof(gddram));
+    expect_control = true;
+    single = false;
+    data = false;
+    command = 0;
+    args_needed = 0;
+    args_received = 0;
+    // datasheet reset values
+    addressing_mode = MODE_PAGE;
+    col_start = 0;
+    col_end = SSD1306_MODEL_WIDTH - 1;
+    page_start = 0;
+    page_end = SSD1306_MODEL_PAGES - 1;
+    col = 0;
+    page = 0;
+    on = false;
+    contrast = 0x7F;
+    reset_counters();
+}
+
+void Ssd1306Model::reset_counters() {
+    data_bytes = 0;
+    command_bytes = 0;
+}
+
+void Ssd1306Model::begin() {
+    expect_control = true;
+}
+
+void Ssd1306Model::end() {
+    // unfinished command arguments carry over, pico-ssd1306 sends every byte in its own transaction
+    expect_control = true;
+}
+
+void Ssd1306Model::write(uint8_t byte) {
+    if (expect_control) {
+        single = byte & 0x80;
+        data = byte & 0x40;
+        expect_control = false;
+        return;
+    }
+
+    if (data) { write_data(byte); }
+    else { write_command(byte); }
+
+    if (single) { expect_control = true; }
+}
+
+uint8_t Ssd1306Model::argument_count(uint8_t command) {
+    switch (command) {
+    case 0x20: case 0x81: case 0x8D: case 0xA8: case 0xD3:
+    case 0xD5: case 0xD9: case 0xDA: case 0xDB:
+        return 1;
+    case 0x21: case 0x22: case 0xA3:
+        return 2;
+    case 0x29: case 0x2A:
+        return 5;
+    case 0x26: case 0x27:
+        return 6;
+    default:
+        return 0;
+    }
+}
+
+void Ssd1306Model::write_command(uint8_t byte) {
+    command_bytes++;
+
+    if (args_received < args_needed) {
+        args[args_received++] = byte;
+        if (args_received == args_needed) { execute(); }
+        return;
+    }
+
+    command = byte;
+    args_needed = argument_count(byte);
+    args_received = 0;
+    if (args_needed == 0) { execute(); }
+}
+
+void Ssd1306Model::execute() {
+    switch (command) {
+    case CMD_MEMORY_MODE:
+        addressing_mode = args[0] & 0x03;
+        break;
+    case CMD_COLUMN_ADDR:
+        col_start = args[0] & 0x7F;
+        col_end = args[1] & 0x7F;
+        col = col_start;
+        break;
+    case CMD_PAGE_ADDR:
+        page_start = args[0] & 0x07;
+        page_end = args[1] & 0x07;
+        page = page_start;
+        break;
+    case CMD_CONTRAST:
+        contrast = args[0];
+        break;
+    case CMD_DISPLAY_OFF:
+        on = false;
+        break;
+    case CMD_DISPLAY_ON:
+        on = true;
+        break;
+    default:
+        // page addressing mode: B0-B7 page start, 00-0F / 10-1F column start nibbles
+        if (command >= 0xB0 && command <= 0xB7) { page = command & 0x07; }
+        else if (command <= 0x0F) { col = (col & 0xF0) | command; }
+        else if (command >= 0x10 && command <= 0x1F) { col = (col & 0x0F) | ((command & 0x0F) << 4); }
+        break;
+    }
+    command = 0;
+    args_needed = 0;
+    args_received = 0;
+}
+
+void Ssd1306Model::write_data(uint8_t byte) {
+    data_bytes++;
+    gddram[page * SSD1306_MODEL_WIDTH + col] = byte;
+
+    switch (addressing_mode) {
+    case MODE_HORIZONTAL:
+        if (col < col_end) { col++; break; }
+        col = col_start;
+        page = page < page_end ? page + 1 : page_start;
+        break;
+    case MODE_VERTICAL:
+        if (page < page_end) { page++; break; }
+        page = page_start;
+        col = col < col_end ? col + 1 : col_start;
+        break;
+    default:
+        // page mode only wraps inside the page
+        col = (col + 1) % SSD1306_MODEL_WIDTH;
+        break;
+    }
+}
+
+bool Ssd1306Model::get_pixel(uint8_t x, uint8_t y) const {
+    if (x >= SSD1306_MODEL_WIDTH || y >= SSD1306_MODEL_PAGES * 8) { return false; }
+    return gddram[(y / 8) * SSD1306_MODEL_WIDTH + x] >> (y & 7) & 1;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define SSD1306_MODEL_WIDTH 128
+#define SSD1306_MODEL_PAGES 8
+
+namespace mock {
+    /// @brief SSD1306 as seen from the i2c bus: decodes control bytes & commands
+    /// and keeps GDDRAM, so what a frame really put on the panel can be checked
+    class Ssd1306Model {
+    private:
+        uint8_t gddram[SSD1306_MODEL_PAGES * SSD1306_MODEL_WIDTH];
+
+        /// @brief next byte of a transaction is a control byte
+        bool expect_control;
+        /// @brief Co bit of the last control byte, only one payload byte follows it
+        bool single;
+        /// @brief D/C# bit of the last control byte
+        bool data;
+
+        /// @brief command that still waits for arguments, 0 if none
+        uint8_t command;
+        uint8_t args[6];
+        uint8_t args_needed, args_received;
+
+        uint8_t addressing_mode;
+        uint8_t col_start, col_end, page_start, page_end;
+        uint8_t col, page;
+        bool on;
+        uint8_t contrast;
+
+        uint32_t data_bytes;
+        uint32_t command_bytes;
+
+        static uint8_t argument_count(uint8_t command);
+        void execute();
+        void write_command(uint8_t byte);
+        void write_data(uint8_t byte);
+
+    public:
+        Ssd1306Model();
+
+        /// @brief power-on state, GDDRAM is cleared too
+        void reset();
+
+        /// @brief START condition addressed to the panel
+        void begin();
+
+        /// @brief byte that follows the address
+        void write(uint8_t byte);
+
+        /// @brief STOP condition
+        void end();
+
+        bool get_pixel(uint8_t x, uint8_t y) const;
+        const uint8_t* get_gddram() const { return gddram; }
+
+        bool is_on() const { return on; }
+        uint8_t get_contrast() const { return contrast; }
+
+        /// @brief GDDRAM bytes written, counters are cleared by reset() & reset_counters()
+        uint32_t get_data_bytes() const { return data_bytes; }
+        /// @brief command & argument bytes received
+        uint32_t get_command_bytes() const { return command_bytes; }
+        void reset_counters();
+    };
+}
@@ -0,0 +1,8 @@
+#pragma once
+#include "pico/stdlib.h"
+
+/// @brief set by mock::set_usb()
+bool tud_cdc_connected();
+
+/// @brief free space in the CDC transmit buffer, stdio_usb writes take it up
+uint32_t tud_cdc_write_available();
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <stdio.h>
+
+/// @brief failed checks so far, main() of a test returns check::result()
+namespace check {
+    inline int failures = 0;
+
+    inline int result(const char* test) {
+        if (failures == 0) { printf("%s: ok\n", test); }
+        else { printf("%s: %d checks failed\n", test, failures); }
+        return failures == 0 ? 0 : 1;
+    }
+}
+
+// a failed check is reported and the test goes on, so one run shows every broken case
+#define CHECK(condition) do { \
+    if (!(condition)) { \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+        check::failures++; \
+    } \
+} while (0)
@@ -0,0 +1,89 @@
+// FrameBuffer::fill_rect() page byte & word writes against per-pixel fills, random rectangles in every mode,
+// clipped at every edge of the screen and empty ones with swapped corners
+
+#include "check.h"
+#include "reference_screen.h"
+
+#include "display_controller/framebuffer.h"
+
+// same for every run, new random screen content every CASES_PER_SCREEN cases
+#define FILL_TEST_CASES 200000
+#define FILL_TEST_CASES_PER_SCREEN 1000
+// corners may lie this far off the screen
+#define FILL_TEST_MARGIN 8
+
+using namespace display_controller;
+
+namespace {
+    int random_coordinate(uint32_t& seed, int screen_size) {
+        return (int)(ReferenceScreen::next_random(seed) % (screen_size + 2 * FILL_TEST_MARGIN)) - FILL_TEST_MARGIN;
+    }
+
+    void reference_fill(ReferenceScreen& screen, int x_start, int y_start, int x_end, int y_end,
+        pico_ssd1306::WriteMode mode) {
+        for (int y = y_start; y <= y_end; y++) {
+            for (int x = x_start; x <= x_end; x++) { screen.plot(x, y, mode); }
+        }
+    }
+
+    void test_random_rects() {
+        uint32_t seed = 0xF111AEC7;
+        FrameBuffer frame;
+        ReferenceScreen reference;
+        uint32_t mismatches = 0;
+        uint32_t unmarked = 0;
+
+        for (uint32_t n = 0; n < FILL_TEST_CASES; n++) {
+            if (n % FILL_TEST_CASES_PER_SCREEN == 0) { reference.randomize(frame, seed); }
+
+            pico_ssd1306::WriteMode mode = (pico_ssd1306::WriteMode)(ReferenceScreen::next_random(seed) % 3);
+            int x_start = random_coordinate(seed, DISPLAY_WIDTH);
+            int x_end = random_coordinate(seed, DISPLAY_WIDTH);
+            int y_start = random_coordinate(seed, DISPLAY_HEIGHT);
+            int y_end = random_coordinate(seed, DISPLAY_HEIGHT);
+            // corners in order most of the time, swapped ones have to draw nothing
+            if (ReferenceScreen::next_random(seed) % 8 != 0) {
+                if (x_start > x_end) { int x = x_start; x_start = x_end; x_end = x; }
+                if (y_start > y_end) { int y = y_start; y_start = y_end; y_end = y; }
+            }
+
+            ReferenceScreen before = reference;
+            frame.clear_dirty();
+            frame.fill_rect(x_start, y_start, x_end, y_end, mode);
+            reference_fill(reference, x_start, y_start, x_end, y_end, mode);
+
+            if (!reference.matches(frame)) {
+                mismatches++;
+                // later cases would all fail on the same pixels
+                reference.randomize(frame, seed);
+                continue;
+            }
+            if (!reference.changes_marked(before, frame)) { unmarked++; }
+        }
+        CHECK(mismatches == 0);
+        CHECK(unmarked == 0);
+    }
+
+    void test_draw_rect() {
+        // outline corners are shared by two edges, INVERT must flip them once
+        FrameBuffer frame;
+        ReferenceScreen reference;
+        frame.clear();
+        frame.draw_rect(3, 5, 40, 30, pico_ssd1306::WriteMode::INVERT);
+        for (int x = 3; x <= 40; x++) {
+            reference.plot(x, 5, pico_ssd1306::WriteMode::ADD);
+            reference.plot(x, 30, pico_ssd1306::WriteMode::ADD);
+        }
+        for (int y = 5; y <= 30; y++) {
+            reference.plot(3, y, pico_ssd1306::WriteMode::ADD);
+            reference.plot(40, y, pico_ssd1306::WriteMode::ADD);
+        }
+        CHECK(reference.matches(frame));
+    }
+}
+
+int main() {
+    test_random_rects();
+    test_draw_rect();
+    return check::result("framebuffer");
+}
@@ -0,0 +1,102 @@
+// Rotated text drawn from glyph atlases against the per-pixel Rotation::deg90 placement of pico-ssd1306,
+// random fonts, modes & anchors, clipped at every edge of the screen
+
+#include "check.h"
+#include "reference_screen.h"
+
+#include "display_controller/framebuffer.h"
+#include "display_controller/glyph_atlas.h"
+#include "../../pico-ssd1306/textRenderer/16x32_font.h"
+
+// same for every run, new random screen content every CASES_PER_SCREEN cases
+#define GLYPH_TEST_CASES 20000
+#define GLYPH_TEST_CASES_PER_SCREEN 50
+#define GLYPH_TEST_MAX_CHARS 4
+
+using namespace display_controller;
+
+namespace {
+    const unsigned char* const fonts[] = { font_5x8, font_8x8, font_12x16, font_16x32 };
+
+    /// @brief pico-ssd1306 drawChar() with Rotation::deg90: glyph pixel (x, y) goes to (anchor_x + height - y, anchor_y + x)
+    void reference_char(ReferenceScreen& screen, const unsigned char* font, char c, int anchor_x, int anchor_y,
+        pico_ssd1306::WriteMode mode) {
+        if (c < 32) { return; }
+        int width = font[0];
+        int height = font[1];
+        int seek = (c - 32) * (width * height) / 8 + 2;
+        int bit = 0;
+        for (int x = 0; x < width; x++) {
+            for (int y = 0; y < height; y++) {
+                if (font[seek] >> bit & 1) { screen.plot(anchor_x + height - y, anchor_y + x, mode); }
+                if (++bit == 8) {
+                    bit = 0;
+                    seek++;
+                }
+            }
+        }
+    }
+
+    /// @brief anchor near an edge of the screen half the time, anywhere around it otherwise
+    int random_anchor(uint32_t& seed, int screen_size, int glyph_size) {
+        uint32_t r = ReferenceScreen::next_random(seed);
+        if (r & 1) {
+            int edge = (r >> 1) & 1 ? -glyph_size : screen_size - glyph_size;
+            return edge + (int)((r >> 2) % (2 * glyph_size + 1));
+        }
+        return (int)((r >> 2) % (screen_size + 2 * glyph_size)) - glyph_size;
+    }
+
+    void test_atlases() {
+        for (const unsigned char* font : fonts) {
+            const RotatedFont* rotated = find_rotated_font(font);
+            CHECK(rotated != nullptr);
+            if (rotated == nullptr) { continue; }
+            CHECK(rotated->width == font[0]);
+            CHECK(rotated->height == font[1]);
+        }
+    }
+
+    void test_random_text() {
+        uint32_t seed = 0x5EED1234;
+        FrameBuffer start;
+        ReferenceScreen start_reference;
+        uint32_t mismatches = 0;
+        uint32_t unmarked = 0;
+
+        for (uint32_t n = 0; n < GLYPH_TEST_CASES; n++) {
+            if (n % GLYPH_TEST_CASES_PER_SCREEN == 0) { start_reference.randomize(start, seed); }
+
+            const unsigned char* font = fonts[ReferenceScreen::next_random(seed) % 4];
+            pico_ssd1306::WriteMode mode = (pico_ssd1306::WriteMode)(ReferenceScreen::next_random(seed) % 3);
+            int anchor_x = random_anchor(seed, DISPLAY_WIDTH, font[1]);
+            int anchor_y = random_anchor(seed, DISPLAY_HEIGHT, font[0] * GLYPH_TEST_MAX_CHARS);
+
+            // printable characters, now & then a control character that's skipped
+            char text[GLYPH_TEST_MAX_CHARS];
+            size_t length = 1 + ReferenceScreen::next_random(seed) % GLYPH_TEST_MAX_CHARS;
+            for (size_t i = 0; i < length; i++) {
+                uint32_t r = ReferenceScreen::next_random(seed);
+                text[i] = r % 20 == 0 ? (char)(r % 32) : (char)(32 + r % 95);
+            }
+
+            FrameBuffer frame = start;
+            ReferenceScreen reference = start_reference;
+            frame.draw_text(font, text, length, anchor_x, anchor_y, mode, pico_ssd1306::Rotation::deg90);
+            for (size_t i = 0; i < length; i++) {
+                reference_char(reference, font, text[i], anchor_x, anchor_y + i * font[0], mode);
+            }
+
+            if (!reference.matches(frame)) { mismatches++; }
+            if (!reference.changes_marked(start_reference, frame)) { unmarked++; }
+        }
+        CHECK(mismatches == 0);
+        CHECK(unmarked == 0);
+    }
+}
+
+int main() {
+    test_atlases();
+    test_random_text();
+    return check::result("glyph_atlas");
+}
@@ -0,0 +1,87 @@
+// ProgressBar::set() moving only the end of the fill against a full redraw of the bar at every level,
+// on random screen content around the bar
+
+#include "check.h"
+#include "reference_screen.h"
+
+#include "display_controller/framebuffer.h"
+#include "display_controller/progress_bar.h"
+
+// same for every run
+#define BAR_TEST_LEVELS 3000
+// battery bar of the main menu
+#define BAR_X_START 3
+#define BAR_Y_START 52
+#define BAR_X_END 124
+#define BAR_Y_END 60
+
+using namespace display_controller;
+
+namespace {
+    /// @brief whole fill area written from scratch, filled columns are counted here without ProgressBar
+    void reference_bar(ReferenceScreen& screen, uint8_t percentage) {
+        if (percentage > 100) { percentage = 100; }
+        int columns = (BAR_X_END - BAR_X_START + 1) * percentage / 100;
+        for (int y = BAR_Y_START; y <= BAR_Y_END; y++) {
+            for (int x = BAR_X_START; x <= BAR_X_END; x++) {
+                bool on = x < BAR_X_START + columns;
+                screen.plot(x, y, on ? pico_ssd1306::WriteMode::ADD : pico_ssd1306::WriteMode::SUBTRACT);
+            }
+        }
+    }
+
+    /// @brief every pixel that changed is inside the columns ProgressBar said it would rewrite
+    bool within_columns(const ReferenceScreen& before, const ReferenceScreen& after, const DirtySpan& columns) {
+        for (int y = 0; y < DISPLAY_HEIGHT; y++) {
+            for (int x = 0; x < DISPLAY_WIDTH; x++) {
+                if (before.get(x, y) == after.get(x, y)) { continue; }
+                if (columns.is_clean() || x < columns.first || x > columns.last) { return false; }
+            }
+        }
+        return true;
+    }
+
+    void test_random_levels() {
+        uint32_t seed = 0xBA77E121;
+        FrameBuffer frame;
+        ReferenceScreen reference;
+        reference.randomize(frame, seed);
+
+        // main menu clears the frame under the bar before it's used
+        ProgressBar bar(BAR_X_START, BAR_Y_START, BAR_X_END, BAR_Y_END);
+        frame.fill_rect(BAR_X_START, BAR_Y_START, BAR_X_END, BAR_Y_END, pico_ssd1306::WriteMode::SUBTRACT);
+        reference_bar(reference, 0);
+        bar.reset();
+        CHECK(reference.matches(frame));
+
+        uint32_t mismatches = 0;
+        uint32_t unmarked = 0;
+        uint32_t outside = 0;
+        int level = 50;
+        for (uint32_t n = 0; n < BAR_TEST_LEVELS; n++) {
+            // mostly steps of a few % as from the battery, now & then a jump or a level above 100
+            uint32_t r = ReferenceScreen::next_random(seed);
+            if (r % 4 == 0) { level = r / 4 % 111; }
+            else { level += (int)(r / 4 % 5) - 2; }
+            if (level < 0) { level = 0; }
+
+            ReferenceScreen before = reference;
+            DirtySpan columns = bar.changed_columns(level);
+            frame.clear_dirty();
+            bar.set(frame, level);
+            reference_bar(reference, level);
+
+            if (!reference.matches(frame)) { mismatches++; }
+            if (!reference.changes_marked(before, frame)) { unmarked++; }
+            if (!within_columns(before, reference, columns)) { outside++; }
+        }
+        CHECK(mismatches == 0);
+        CHECK(unmarked == 0);
+        CHECK(outside == 0);
+    }
+}
+
+int main() {
+    test_random_levels();
+    return check::result("progress_bar");
+}
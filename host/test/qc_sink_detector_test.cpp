@@ -0,0 +1,226 @@
+// QcSinkDetector::update() fed with line voltages over time, one measurement per charging task period
+
+#include "check.h"
+
+#include "charging_protocols/quick_charge.h"
+#include "charging_protocols/qc_sink_detector.h"
+
+using namespace charging_protocols;
+
+namespace {
+    const uint64_t SAMPLE_US = 1000;
+    const uint64_t BC_DONE_US = QC_T_GLITCH_BC_DONE_MS * 1000;
+    const uint64_t DEBOUNCE_US = QC_T_GLITCH_V_CHANGE_MIN_MS * 1000;
+
+    struct Feed {
+        uint32_t changes;
+        /// @brief time of the first reported change, 0 if there was none
+        uint64_t first_change;
+    };
+
+    /// @brief keep both lines at given voltages from `from` until just before `to`
+    Feed hold(QcSinkDetector& detector, uint16_t dp, uint16_t dm, uint64_t from, uint64_t to) {
+        Feed feed = { 0, 0 };
+        for (uint64_t now = from; now < to; now += SAMPLE_US) {
+            if (detector.update(dp, dm, now) && feed.changes++ == 0) { feed.first_change = now; }
+        }
+        return feed;
+    }
+
+    /// @brief sink holds D+ at 0.6v until BC is done, D- follows through the short, then the short is opened
+    /// @return time the QC_5v report is stable at
+    uint64_t handshake(QcSinkDetector& detector, uint64_t start) {
+        uint64_t done = start + BC_DONE_US + DEBOUNCE_US + SAMPLE_US;
+        hold(detector, 600, 600, start, done);
+        hold(detector, 600, 0, done, done + DEBOUNCE_US);
+        return done + DEBOUNCE_US;
+    }
+
+    void test_detached() {
+        QcSinkDetector detector(BC_DONE_US, DEBOUNCE_US);
+        Feed feed = hold(detector, 0, 0, 0, 100000);
+        CHECK(feed.changes == 0);
+        CHECK(detector.get_mode() == ChargingModes::NotConnected);
+        CHECK(!detector.is_qc());
+    }
+
+    void test_generic_sink() {
+        // BC1.2 sink that never waits for QC, reported after the debounce time exactly
+        QcSinkDetector detector(BC_DONE_US, DEBOUNCE_US);
+        Feed feed = hold(detector, 600, 600, 0, BC_DONE_US / 2);
+        CHECK(feed.changes == 1);
+        CHECK(feed.first_change == DEBOUNCE_US);
+        CHECK(detector.get_mode() == ChargingModes::GEN_5v);
+        CHECK(!detector.is_qc());
+    }
+
+    void test_handshake() {
+        QcSinkDetector detector(BC_DONE_US, DEBOUNCE_US);
+        Feed feed = hold(detector, 600, 600, 0, BC_DONE_US);
+        CHECK(feed.changes == 1);
+        CHECK(!detector.is_qc());
+
+        // BC done, D- still follows D+ through the short, that's no 12v request
+        feed = hold(detector, 600, 600, BC_DONE_US, BC_DONE_US + DEBOUNCE_US + 100000);
+        CHECK(detector.is_qc());
+        CHECK(feed.changes == 1);
+        CHECK(feed.first_change == BC_DONE_US + DEBOUNCE_US);
+        CHECK(detector.get_mode() == ChargingModes::QC_5v);
+
+        // short opened, D- falls to 0v: still 5v
+        uint64_t now = BC_DONE_US + DEBOUNCE_US + 100000;
+        feed = hold(detector, 600, 0, now, now + 100000);
+        CHECK(feed.changes == 0);
+        CHECK(detector.get_mode() == ChargingModes::QC_5v);
+
+        // now 0.6v on D- is a 12v request
+        now += 100000;
+        feed = hold(detector, 600, 600, now, now + 100000);
+        CHECK(feed.changes == 1);
+        CHECK(feed.first_change == now + DEBOUNCE_US);
+        CHECK(detector.get_mode() == ChargingModes::QC_12v);
+    }
+
+    void test_bc_timer_restarts() {
+        // D+ leaving 0.6v before BC is done starts the wait over
+        QcSinkDetector detector(BC_DONE_US, DEBOUNCE_US);
+        hold(detector, 600, 600, 0, BC_DONE_US / 2);
+        hold(detector, 3300, 3300, BC_DONE_US / 2, BC_DONE_US / 2 + SAMPLE_US);
+        uint64_t restart = BC_DONE_US / 2 + SAMPLE_US;
+        hold(detector, 600, 600, restart, restart + BC_DONE_US - SAMPLE_US);
+        CHECK(!detector.is_qc());
+        hold(detector, 600, 600, restart + BC_DONE_US - SAMPLE_US, restart + BC_DONE_US + SAMPLE_US);
+        CHECK(detector.is_qc());
+    }
+
+    void test_every_request() {
+        // each row of the D+/D- table, reported debounce time after the sink set it
+        const struct {
+            uint16_t dp, dm;
+            ChargingModes mode;
+        } requests[] = {
+            { 3300, 600, ChargingModes::QC_9v },
+            { 600, 600, ChargingModes::QC_12v },
+            { 3300, 3300, ChargingModes::QC_20v },
+            { 600, 3300, ChargingModes::QC_Var },
+            { 600, 0, ChargingModes::QC_5v },
+        };
+
+        QcSinkDetector detector(BC_DONE_US, DEBOUNCE_US);
+        uint64_t now = handshake(detector, 0);
+        for (const auto& request : requests) {
+            Feed feed = hold(detector, request.dp, request.dm, now, now + 100000);
+            CHECK(feed.changes == 1);
+            CHECK(feed.first_change == now + DEBOUNCE_US);
+            CHECK(detector.get_mode() == request.mode);
+            now += 100000;
+        }
+    }
+
+    void test_debounce() {
+        QcSinkDetector detector(BC_DONE_US, DEBOUNCE_US);
+        uint64_t now = handshake(detector, 0);
+
+        // request shorter than the glitch filter is ignored
+        Feed feed = hold(detector, 3300, 600, now, now + DEBOUNCE_US);
+        feed.changes += hold(detector, 600, 0, now + DEBOUNCE_US, now + 100000).changes;
+        CHECK(feed.changes == 0);
+        CHECK(detector.get_mode() == ChargingModes::QC_5v);
+        now += 100000;
+
+        // D- jumping across a boundary on every sample never settles
+        feed = { 0, 0 };
+        for (uint32_t i = 0; i < 1000; i++) {
+            feed.changes += detector.update(600, i % 2 ? 600 : 0, now);
+            now += SAMPLE_US;
+        }
+        CHECK(feed.changes == 0);
+        CHECK(detector.get_mode() == ChargingModes::QC_5v);
+    }
+
+    void test_hysteresis() {
+        QcSinkDetector detector(BC_DONE_US, DEBOUNCE_US);
+        uint64_t now = handshake(detector, 0);
+        hold(detector, 600, 600, now, now + 100000);
+        now += 100000;
+        CHECK(detector.get_mode() == ChargingModes::QC_12v);
+
+        // D- sagging below the 0.6v boundary, but not past the hysteresis
+        Feed feed = hold(detector, 600, QC_LEVEL_MID_MV - QC_LEVEL_HYSTERESIS_MV, now, now + 100000);
+        CHECK(feed.changes == 0);
+        now += 100000;
+        feed = hold(detector, 600, QC_LEVEL_MID_MV - QC_LEVEL_HYSTERESIS_MV - 1, now, now + 100000);
+        CHECK(feed.changes == 1);
+        CHECK(detector.get_mode() == ChargingModes::QC_5v);
+        now += 100000;
+
+        // and back up from 0v
+        feed = hold(detector, 600, QC_LEVEL_MID_MV + QC_LEVEL_HYSTERESIS_MV - 1, now, now + 100000);
+        CHECK(feed.changes == 0);
+        now += 100000;
+        feed = hold(detector, 600, QC_LEVEL_MID_MV + QC_LEVEL_HYSTERESIS_MV, now, now + 100000);
+        CHECK(feed.changes == 1);
+        CHECK(detector.get_mode() == ChargingModes::QC_12v);
+        now += 100000;
+
+        // 3.3v boundary from both sides
+        hold(detector, 3300, 600, now, now + 100000);
+        now += 100000;
+        CHECK(detector.get_mode() == ChargingModes::QC_9v);
+        feed = hold(detector, QC_LEVEL_HIGH_MV - QC_LEVEL_HYSTERESIS_MV, 600, now, now + 100000);
+        CHECK(feed.changes == 0);
+        now += 100000;
+        feed = hold(detector, QC_LEVEL_HIGH_MV - QC_LEVEL_HYSTERESIS_MV - 1, 600, now, now + 100000);
+        CHECK(feed.changes == 1);
+        CHECK(detector.get_mode() == ChargingModes::QC_12v);
+        now += 100000;
+        feed = hold(detector, QC_LEVEL_HIGH_MV + QC_LEVEL_HYSTERESIS_MV - 1, 600, now, now + 100000);
+        CHECK(feed.changes == 0);
+        now += 100000;
+        feed = hold(detector, QC_LEVEL_HIGH_MV + QC_LEVEL_HYSTERESIS_MV, 600, now, now + 100000);
+        CHECK(feed.changes == 1);
+        CHECK(detector.get_mode() == ChargingModes::QC_9v);
+    }
+
+    void test_release() {
+        QcSinkDetector detector(BC_DONE_US, DEBOUNCE_US);
+        uint64_t now = handshake(detector, 0);
+        hold(detector, 3300, 600, now, now + 100000);
+        now += 100000;
+
+        // unplugged: QC is gone at once, the mode after the debounce time
+        Feed feed = hold(detector, 0, 0, now, now + SAMPLE_US);
+        CHECK(!detector.is_qc());
+        feed = hold(detector, 0, 0, now + SAMPLE_US, now + 100000);
+        CHECK(feed.changes == 1);
+        CHECK(feed.first_change == now + DEBOUNCE_US);
+        CHECK(detector.get_mode() == ChargingModes::NotConnected);
+        now += 100000;
+
+        // plugged in again, requests count only after a new handshake
+        feed = hold(detector, 3300, 600, now, now + BC_DONE_US / 2);
+        CHECK(detector.get_mode() == ChargingModes::GEN_5v);
+        CHECK(!detector.is_qc());
+        now += BC_DONE_US / 2;
+        now = handshake(detector, now);
+        CHECK(detector.is_qc());
+        CHECK(detector.get_mode() == ChargingModes::QC_5v);
+
+        // reset() forgets the sink
+        detector.reset();
+        CHECK(!detector.is_qc());
+        CHECK(detector.get_mode() == ChargingModes::NotConnected);
+    }
+}
+
+int main() {
+    test_detached();
+    test_generic_sink();
+    test_handshake();
+    test_bc_timer_restarts();
+    test_every_request();
+    test_debounce();
+    test_hysteresis();
+    test_release();
+    return check::result("qc_sink_detector");
+}
@@ -0,0 +1,122 @@
+// QuickChargePort_alt::poll() driven to continuous mode voltages off the 200mV pulse grid, by a request and
+// by a power limit, against an adapter that follows every mode change & pulse
+
+#include "check.h"
+
+#include "charging_protocols/quick_charge.h"
+
+using namespace charging_protocols;
+
+namespace {
+    const uint64_t POLL_US = 1000;
+    const uint64_t SETTLE_US = 20 * 1000000;
+
+    /// @brief QC adapter: D+/D- shorted until the sink holds 0.6v on D+, no timed sequences of its own
+    class AdapterLines : public DataLines {
+    public:
+        bool bc_done = false;
+
+        bool drive(LineDrive dp, LineDrive) override {
+            if (dp == LineDrive::V0_6) { bc_done = true; }
+            return true;
+        }
+        bool read_dm() override { return !bc_done; }
+    };
+
+    struct Run {
+        /// @brief times the estimated output changed
+        uint32_t changes;
+        /// @brief highest estimate seen
+        uint16_t highest;
+    };
+
+    /// @brief poll from `now` until `until`, estimate changes are counted & the highest one seen after `from`
+    Run poll(QuickChargePort_alt& port, uint64_t& now, uint64_t until, uint64_t from = 0) {
+        Run run = { 0, 0 };
+        uint16_t last = port.get_millivolts_estimated();
+        for (; now < until; now += POLL_US) {
+            port.poll(now);
+            uint16_t estimate = port.get_millivolts_estimated();
+            if (estimate != last) { run.changes++; }
+            if (now >= from && estimate > run.highest) { run.highest = estimate; }
+            last = estimate;
+        }
+        return run;
+    }
+
+    /// @brief handshake done, adapter at QC_5v
+    uint64_t connect(QuickChargePort_alt& port) {
+        uint64_t now = 0;
+        port.begin();
+        poll(port, now, (QC_T_GLITCH_BC_DONE_MS + 1000) * 1000);
+        CHECK(port.is_qc());
+        CHECK(port.get_millivolts_estimated() == 5000);
+        return now;
+    }
+
+    void test_off_grid_target() {
+        const uint16_t targets[] = { 11900, 7300, 3700, 5100 };
+        for (uint16_t target : targets) {
+            AdapterLines lines;
+            QuickChargePort_alt port(&lines);
+            uint64_t now = connect(port);
+
+            port.request_millivolts(target);
+            // may pass a fixed mode above the target on the way, ends below it
+            Run run = poll(port, now, now + SETTLE_US);
+            CHECK(!port.is_busy());
+            CHECK(port.get_millivolts_estimated() == step_floor(target));
+            // a few mode changes & one pulse train, no hunting around the target
+            CHECK(run.changes < 40);
+
+            // stays there
+            run = poll(port, now, now + SETTLE_US);
+            CHECK(run.changes == 0);
+        }
+    }
+
+    void test_off_grid_limit() {
+        AdapterLines lines;
+        QuickChargePort_alt port(&lines);
+        uint64_t now = connect(port);
+        port.request_millivolts(QC3_CLASS_A_MAX_VOLTAGE_MV);
+        poll(port, now, now + SETTLE_US);
+        CHECK(port.get_millivolts_estimated() == QC3_CLASS_A_MAX_VOLTAGE_MV);
+
+        // output above the limit is stepped down to the grid below it
+        port.set_voltage_limit(9100);
+        Run run = poll(port, now, now + SETTLE_US);
+        CHECK(!port.is_busy());
+        CHECK(port.get_millivolts_estimated() == 9000);
+        CHECK(run.changes < 40);
+        run = poll(port, now, now + SETTLE_US);
+        CHECK(run.changes == 0);
+
+        // a request above it ends on the same step
+        port.request_millivolts(QC3_CLASS_A_MAX_VOLTAGE_MV);
+        run = poll(port, now, now + SETTLE_US, now);
+        CHECK(port.get_millivolts_estimated() == 9000);
+        CHECK(run.highest <= 9100);
+    }
+
+    void test_off_grid_class() {
+        // class limits are on the grid, a target clamped to them stays there
+        AdapterLines lines;
+        QuickChargePort_alt port(&lines);
+        uint64_t now = connect(port);
+        port.set_voltage_limit(10900);
+        port.request_millivolts(10900);
+        poll(port, now, now + SETTLE_US);
+        port.set_class(QcClass::B);
+        Run run = poll(port, now, now + SETTLE_US);
+        CHECK(run.changes == 0);
+        CHECK(port.get_millivolts_estimated() == 10800);
+    }
+}
+
+int main() {
+    test_off_grid_target();
+    test_off_grid_limit();
+    test_off_grid_class();
+    return check::result("quick_charge");
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include "display_controller/framebuffer.h"
+
+/// @brief Plain per-pixel model of the screen, FrameBuffer's byte & word paths are compared with it.
+/// Drawing here is kept as simple as possible on purpose, one pixel at a time.
+class ReferenceScreen {
+private:
+    bool pixels[DISPLAY_HEIGHT][DISPLAY_WIDTH];
+
+public:
+    ReferenceScreen() { memset(pixels, 0, sizeof(pixels)); }
+
+    /// @brief pixels off the screen are ignored
+    void plot(int x, int y, pico_ssd1306::WriteMode mode) {
+        if (x < 0 || x >= DISPLAY_WIDTH || y < 0 || y >= DISPLAY_HEIGHT) { return; }
+        switch (mode) {
+        case pico_ssd1306::WriteMode::ADD: pixels[y][x] = true; break;
+        case pico_ssd1306::WriteMode::SUBTRACT: pixels[y][x] = false; break;
+        case pico_ssd1306::WriteMode::INVERT: pixels[y][x] = !pixels[y][x]; break;
+        }
+    }
+
+    bool get(int x, int y) const { return pixels[y][x]; }
+
+    /// @brief same random pixels here & in the frame buffer, so SUBTRACT & INVERT have something to work on
+    void randomize(display_controller::FrameBuffer& frame, uint32_t& seed) {
+        frame.clear();
+        for (int y = 0; y < DISPLAY_HEIGHT; y++) {
+            for (int x = 0; x < DISPLAY_WIDTH; x++) {
+                pixels[y][x] = next_random(seed) & 1;
+                if (pixels[y][x]) { frame.set_pixel(x, y); }
+            }
+        }
+        frame.clear_dirty();
+    }
+
+    /// @brief every pixel is the same in the frame buffer
+    bool matches(const display_controller::FrameBuffer& frame) const {
+        for (int y = 0; y < DISPLAY_HEIGHT; y++) {
+            for (int x = 0; x < DISPLAY_WIDTH; x++) {
+                if (((frame.page_data(y / 8)[x] >> (y & 7)) & 1) != pixels[y][x]) { return false; }
+            }
+        }
+        return true;
+    }
+
+    /// @brief every pixel that differs from `before` is inside a dirty span of the frame buffer
+    bool changes_marked(const ReferenceScreen& before, const display_controller::FrameBuffer& frame) const {
+        for (int y = 0; y < DISPLAY_HEIGHT; y++) {
+            const display_controller::DirtySpan& span = frame.dirty_span(y / 8);
+            for (int x = 0; x < DISPLAY_WIDTH; x++) {
+                if (pixels[y][x] == before.pixels[y][x]) { continue; }
+                if (span.is_clean() || x < span.first || x > span.last) { return false; }
+            }
+        }
+        return true;
+    }
+
+    /// @brief xorshift32, same cases on every run
+    static uint32_t next_random(uint32_t& state) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+};
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stdint.h>
+
+/// @brief Possible configurations of all ports, QC both input & output
+enum class ChargingModes : uint8_t {
+    GEN_5v,
+    QC_5v,
+    QC_9v,
+    QC_12v,
+    QC_20v,
+    QC_Var,
+    PD_5v,
+    PD_9v,
+    PD_12v,
+    PD_20v,
+    PD_Var,
+    NotConnected
+};
+
+static const char* ChargingModes_string[] = {
+    "GEN_5v",
+    "QC_5v",
+    "QC_9v",
+    "QC_12v",
+    "QC_20v",
+    "QC_Var",
+    "PD_5v",
+    "PD_9v",
+    "PD_12v",
+    "PD_20v",
+    "PD_Var",
+    "NotConnected"
+};
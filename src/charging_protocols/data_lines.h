@@ -0,0 +1,92 @@
+#pragma once
+
+#include "pico/stdlib.h"
+#include "hardware/structs/sio.h"
+
+namespace charging_protocols {
+    /// @brief level put on a data line through its two resistor pins
+    enum class LineDrive : uint8_t {
+        HiZ,        // both pins are inputs
+        V0,         // high: 0, low: 0
+        V0_6,       // high: 1, low: 0
+        V2_7,       // high: 0, low: 1
+        V3_3        // high: 1, low: 1
+    };
+
+    /// @brief D+ & D- of one port, a new state is applied to both lines at once
+    class DataLines {
+    public:
+        /// @brief put given levels on D+ & D-. A line that goes to HiZ is released before anything else changes,
+        /// it never drives its new (low) value first
+        /// @return false if the driver's queue behind a running timed sequence is full, nothing changes then
+        virtual bool drive(LineDrive dp, LineDrive dm) = 0;
+        /// @brief logic level seen on D- (its high pin), used to detect the D+/D- short
+        virtual bool read_dm() = 0;
+
+        // Timed sequences, drivers without a timer of their own return false and the caller times steps itself.
+        // Anything sent while a sequence runs waits for it to end, a driver never blocks on it though: it returns
+        // false once its queue is full.
+
+        /// @brief keep current levels for `us`
+        virtual bool hold(uint32_t) { return false; }
+        /// @brief `count` pulses: active levels, then idle levels, each held `hold_us`. Lines stay idle afterwards
+        virtual bool pulses(LineDrive, LineDrive, LineDrive, LineDrive, uint16_t, uint32_t) { return false; }
+        /// @brief is a timed sequence still running
+        virtual bool is_busy() { return false; }
+        /// @brief timer of the sequences follows a new clk_sys frequency
+        virtual void clock_changed() {}
+    };
+
+    /// @brief value of the high (true) or low (false) pin for given level
+    constexpr bool drive_bit(LineDrive level, bool high) {
+        return high ? (level == LineDrive::V0_6 || level == LineDrive::V3_3)
+            : (level == LineDrive::V2_7 || level == LineDrive::V3_3);
+    }
+
+    /// @brief Data lines on fixed GPIOs. Masks are built at compile time and every drive() is two SIO
+    /// register writes, so D+ & D- never show a level between the old and the new state.
+    /// @tparam DpHigh,DpLow pins of the D+ resistor pair
+    /// @tparam DmHigh,DmLow pins of the D- resistor pair
+    template <uint8_t DpHigh, uint8_t DpLow, uint8_t DmHigh, uint8_t DmLow>
+    class SioDataLines : public DataLines {
+    public:
+        static constexpr uint32_t MASK = (1u << DpHigh) | (1u << DpLow) | (1u << DmHigh) | (1u << DmLow);
+        static_assert(DpHigh < 30 && DpLow < 30 && DmHigh < 30 && DmLow < 30, "RP2040 has GPIO 0-29");
+        static_assert(__builtin_popcount(MASK) == 4, "data line pins have to be distinct");
+
+        /// @brief pins that are outputs for given levels
+        static constexpr uint32_t oe_bits(LineDrive dp, LineDrive dm) {
+            return (dp == LineDrive::HiZ ? 0 : (1u << DpHigh) | (1u << DpLow))
+                | (dm == LineDrive::HiZ ? 0 : (1u << DmHigh) | (1u << DmLow));
+        }
+
+        /// @brief output values for given levels, pins that are inputs are left low
+        static constexpr uint32_t value_bits(LineDrive dp, LineDrive dm) {
+            return ((uint32_t)drive_bit(dp, true) << DpHigh) | ((uint32_t)drive_bit(dp, false) << DpLow)
+                | ((uint32_t)drive_bit(dm, true) << DmHigh) | ((uint32_t)drive_bit(dm, false) << DmLow);
+        }
+
+        SioDataLines() {
+            for (uint8_t pin : { DpHigh, DpLow, DmHigh, DmLow }) {
+                gpio_init(pin);
+                // setting up pulls, else it won't work
+                gpio_pull_down(pin);
+            }
+        }
+
+        /// @brief Values go first: they're invisible on pins that are still inputs and change together
+        /// on pins that stay outputs. Pins that are released keep their value, so they aren't pulled to 0v
+        /// before their output enable follows. Output enables follow, so pins switch direction together as well.
+        /// Toggle registers only touch bits that differ, other GPIOs aren't affected.
+        bool drive(LineDrive dp, LineDrive dm) override {
+            uint32_t oe = oe_bits(dp, dm);
+            sio_hw->gpio_togl = (sio_hw->gpio_out ^ value_bits(dp, dm)) & oe & MASK;
+            sio_hw->gpio_oe_togl = (sio_hw->gpio_oe ^ oe) & MASK;
+            return true;
+        }
+
+        bool read_dm() override {
+            return sio_hw->gpio_in & (1u << DmHigh);
+        }
+    };
+};
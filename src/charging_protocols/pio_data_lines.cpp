@@ -0,0 +1,13 @@
+#include "pio_data_lines.h"
+
+using namespace charging_protocols;
+
+uint charging_protocols::qc_lines_offset(PIO pio) {
+    static int offsets[NUM_PIOS] = { -1, -1 };
+
+    uint index = pio_get_index(pio);
+    if (offsets[index] < 0) {
+        offsets[index] = pio_add_program(pio, &qc_lines_program);
+    }
+    return offsets[index];
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+
+#include "data_lines.h"
+#include "qc_lines.pio.h"
+
+// longest hold of one state in a single PIO command, 16 bit loop counter at 1us per cycle
+#define QC_LINES_MAX_HOLD_US (0xFFFF + QC_LINES_OVERHEAD)
+// TX FIFO isn't joined, RX reports finished commands
+#define QC_LINES_TX_FIFO_WORDS 4
+#define QC_LINES_COMMAND_WORDS 2
+
+namespace charging_protocols {
+    /// @brief load qc_lines program into given PIO, it's loaded once and shared by all of its state machines
+    /// @return offset of the program
+    uint qc_lines_offset(PIO pio);
+
+    /// @brief Data lines driven by a PIO state machine. Levels, holds and pulse trains are timed by the PIO
+    /// to 1us, the CPU only pushes commands into the FIFO and checks when they're done.
+    /// @tparam DpHigh,DpLow pins of the D+ resistor pair
+    /// @tparam DmHigh,DmLow pins of the D- resistor pair, all 4 pins have to be consecutive
+    template <uint8_t DpHigh, uint8_t DpLow, uint8_t DmHigh, uint8_t DmLow>
+    class PioDataLines : public DataLines {
+    private:
+        using Masks = SioDataLines<DpHigh, DpLow, DmHigh, DmLow>;
+        static constexpr uint8_t BASE = __builtin_ctz(Masks::MASK);
+        static_assert(Masks::MASK == 0xFu << BASE, "PIO drives 4 consecutive pins");
+
+        PIO _pio;
+        uint _sm;
+        /// @brief command bits of levels on the lines once all commands are done
+        uint8_t _state;
+        /// @brief commands that weren't reported done yet
+        uint8_t _pending;
+
+        /// @brief pin values in low nibble, pin directions in high nibble
+        static constexpr uint8_t state_bits(LineDrive dp, LineDrive dm) {
+            return (Masks::value_bits(dp, dm) >> BASE) | (Masks::oe_bits(dp, dm) >> BASE << 4);
+        }
+
+        /// @brief PIO writes values before pindirs, so pins that are inputs in `state` keep the value they had
+        /// in `from`. A released pin then doesn't drive 0v for a cycle before it lets go
+        static constexpr uint8_t keep_released(uint8_t from, uint8_t state) {
+            uint8_t released = ~(state >> 4) & 0xF;
+            return (state & ~released) | (from & released);
+        }
+
+        /// @brief queue one command, never waits for the FIFO
+        /// @return false if there's no room for it behind the commands already queued
+        bool send(uint8_t first, uint8_t second, uint32_t repeats, uint32_t hold_us) {
+            if (pio_sm_get_tx_fifo_level(_pio, _sm) > QC_LINES_TX_FIFO_WORDS - QC_LINES_COMMAND_WORDS) { return false; }
+
+            uint32_t cycles = hold_us > QC_LINES_OVERHEAD ? hold_us - QC_LINES_OVERHEAD : 0;
+            if (cycles > 0xFFFF) { cycles = 0xFFFF; }
+            pio_sm_put(_pio, _sm, first | (second << 8) | (cycles << 16));
+            pio_sm_put(_pio, _sm, repeats - 1);
+            _state = second;
+            _pending++;
+            return true;
+        }
+    public:
+        /// @param pio PIO block that runs the port, claims one of its free state machines
+        PioDataLines(PIO pio) {
+            _pio = pio;
+            _sm = pio_claim_unused_sm(pio, true);
+            _state = state_bits(LineDrive::HiZ, LineDrive::HiZ);
+            _pending = 0;
+            qc_lines_program_init(pio, _sm, qc_lines_offset(pio), BASE);
+        }
+
+        bool drive(LineDrive dp, LineDrive dm) override {
+            uint8_t state = keep_released(_state, state_bits(dp, dm));
+            return send(state, state, 1, 0);
+        }
+
+        bool read_dm() override {
+            return gpio_get(DmHigh);
+        }
+
+        bool hold(uint32_t us) override {
+            // long holds are split into repeats of the same state
+            uint32_t repeats = us / (2 * QC_LINES_MAX_HOLD_US) + 1;
+            return send(_state, _state, repeats, us / (2 * repeats));
+        }
+
+        bool pulses(LineDrive dp_active, LineDrive dm_active, LineDrive dp_idle, LineDrive dm_idle,
+            uint16_t count, uint32_t hold_us) override {
+            if (count == 0) { return true; }
+            uint8_t active = keep_released(_state, state_bits(dp_active, dm_active));
+            uint8_t idle = keep_released(active, state_bits(dp_idle, dm_idle));
+            // going from idle back to active has to keep released pins as well, else the CPU times the train
+            if (count > 1 && keep_released(idle, active) != active) { return false; }
+            return send(active, idle, count, hold_us);
+        }
+
+        bool is_busy() override {
+            while (!pio_sm_is_rx_fifo_empty(_pio, _sm)) {
+                pio_sm_get(_pio, _sm);
+                if (_pending > 0) { _pending--; }
+            }
+            return _pending > 0;
+        }
+
+        void clock_changed() override {
+            // a running hold finishes at the new rate, it's only off by the cycles before the change
+            pio_sm_set_clkdiv(_pio, _sm, qc_lines_clkdiv());
+        }
+    };
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "charging_modes.h"
+
+namespace charging_protocols {
+    /// @brief fault flags of a port, more of them can be set at once
+    enum PortFault : uint8_t {
+        PORT_FAULT_NONE = 0,
+        PORT_FAULT_PANIC = 1 << 0,          // output was shut down by panic()
+        PORT_FAULT_OVERTEMP = 1 << 1,       // port is limited because of temperature
+    };
+
+    /// @brief snapshot of a port published by charging_protocols, small enough to be copied by value
+    /// into display commands & telemetry
+    struct PortState {
+        /// @brief output voltage, estimated from requests & pulses, 0 if unknown
+        uint16_t millivolts;
+        ChargingModes mode;
+        /// @brief other side has finished QC handshake
+        uint8_t qc : 1;
+        /// @brief PortFault flags
+        uint8_t faults : 7;
+
+        bool operator==(const PortState& other) const {
+            return millivolts == other.millivolts && mode == other.mode && qc == other.qc && faults == other.faults;
+        }
+        bool operator!=(const PortState& other) const { return !(*this == other); }
+    };
+    static_assert(sizeof(PortState) == 4, "port state has to stay packed");
+
+    /// @brief state of a port nothing is connected to
+    constexpr PortState PORT_STATE_DISCONNECTED = { 0, ChargingModes::NotConnected, 0, PORT_FAULT_NONE };
+};
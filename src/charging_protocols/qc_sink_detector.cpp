@@ -0,0 +1,107 @@
+#include "qc_sink_detector.h"
+
+using namespace charging_protocols;
+
+// D+/D- table of QC2.0, every row is checked at nominal voltages & at the edges of its level
+namespace {
+    struct ModeRow {
+        uint16_t dp_millivolts;
+        uint16_t dm_millivolts;
+        ChargingModes mode;
+    };
+
+    constexpr ModeRow mode_table[] = {
+        { 600, 0, ChargingModes::QC_5v },
+        { 3300, 600, ChargingModes::QC_9v },
+        { 600, 600, ChargingModes::QC_12v },
+        { 3300, 3300, ChargingModes::QC_20v },
+        { 600, 3300, ChargingModes::QC_Var },
+        // sink detached
+        { 0, 0, ChargingModes::NotConnected },
+        // not in the table, BC1.2 only sinks
+        { 3300, 0, ChargingModes::GEN_5v },
+        { 0, 600, ChargingModes::GEN_5v },
+        // edges of the levels
+        { QC_LEVEL_MID_MV, QC_LEVEL_MID_MV - 1, ChargingModes::QC_5v },
+        { QC_LEVEL_HIGH_MV - 1, QC_LEVEL_MID_MV, ChargingModes::QC_12v },
+        { QC_LEVEL_HIGH_MV, QC_LEVEL_HIGH_MV - 1, ChargingModes::QC_9v },
+        { QC_LEVEL_HIGH_MV - 1, QC_LEVEL_HIGH_MV, ChargingModes::QC_Var },
+        { QC_LEVEL_HIGH_MV, QC_LEVEL_HIGH_MV, ChargingModes::QC_20v },
+        // ADC full scale
+        { 4095 * 3300 / 4096, 4095 * 3300 / 4096, ChargingModes::QC_20v },
+    };
+
+    constexpr bool mode_table_matches() {
+        for (const ModeRow& row : mode_table) {
+            if (mode_from_millivolts(row.dp_millivolts, row.dm_millivolts) != row.mode) { return false; }
+        }
+        return true;
+    }
+
+    static_assert(mode_table_matches(), "mode_from_millivolts() doesn't match the QC2.0 D+/D- table");
+
+    // noise smaller than the hysteresis doesn't move a line
+    static_assert(classify_level(QC_LEVEL_MID_MV + QC_LEVEL_HYSTERESIS_MV - 1, LineLevel::V0) == LineLevel::V0);
+    static_assert(classify_level(QC_LEVEL_MID_MV - QC_LEVEL_HYSTERESIS_MV, LineLevel::V0_6) == LineLevel::V0_6);
+    static_assert(classify_level(QC_LEVEL_HIGH_MV + QC_LEVEL_HYSTERESIS_MV - 1, LineLevel::V0_6) == LineLevel::V0_6);
+    static_assert(classify_level(QC_LEVEL_HIGH_MV - QC_LEVEL_HYSTERESIS_MV, LineLevel::V3_3) == LineLevel::V3_3);
+}
+
+QcSinkDetector::QcSinkDetector(uint32_t bc_done_us, uint32_t debounce_us) {
+    _bc_done_us = bc_done_us;
+    _debounce_us = debounce_us;
+    reset();
+}
+
+void QcSinkDetector::reset() {
+    _dp = LineLevel::V0;
+    _dm = LineLevel::V0;
+    _bc_timing = false;
+    _bc_since = 0;
+    _bc_done = false;
+    _short_open = false;
+    _mode = ChargingModes::NotConnected;
+    _candidate = ChargingModes::NotConnected;
+    _candidate_since = 0;
+}
+
+bool QcSinkDetector::update(uint16_t dp_millivolts, uint16_t dm_millivolts, uint64_t now) {
+    _dp = classify_level(dp_millivolts, _dp);
+    _dm = classify_level(dm_millivolts, _dm);
+
+    ChargingModes target;
+    if (_dp == LineLevel::V0) {
+        // sink released D+, it has to go through the handshake again
+        _bc_timing = false;
+        _bc_done = false;
+        _short_open = false;
+        target = mode_from_levels(_dp, _dm);
+    }
+    else if (!_bc_done) {
+        if (_dp != LineLevel::V0_6) {
+            _bc_timing = false;
+        }
+        else if (!_bc_timing) {
+            _bc_timing = true;
+            _bc_since = now;
+        }
+        else if (now - _bc_since >= _bc_done_us) {
+            _bc_done = true;
+        }
+        target = _bc_done ? ChargingModes::QC_5v : ChargingModes::GEN_5v;
+    }
+    else {
+        // D- follows D+ through the short until the source opens it, that's no 12v request
+        if (_dm == LineLevel::V0) { _short_open = true; }
+        target = _short_open ? mode_from_levels(_dp, _dm) : ChargingModes::QC_5v;
+    }
+
+    if (target != _candidate) {
+        _candidate = target;
+        _candidate_since = now;
+    }
+    if (_candidate == _mode || now - _candidate_since < _debounce_us) { return false; }
+
+    _mode = _candidate;
+    return true;
+}
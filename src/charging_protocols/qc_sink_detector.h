@@ -0,0 +1,104 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "charging_modes.h"
+
+// D+/D- level boundaries when our port is the QC source, QC2.0 VDAT_REF is 0.25-0.4V and VSEL_REF 1.8-2.2V
+#define QC_LEVEL_MID_MV                 325
+#define QC_LEVEL_HIGH_MV                2000
+// a level is left only when the line is this far past the boundary
+#define QC_LEVEL_HYSTERESIS_MV          50
+
+namespace charging_protocols {
+    /// @brief nominal levels a QC sink drives on D+/D-
+    enum class LineLevel : uint8_t {
+        V0,
+        V0_6,
+        V3_3
+    };
+
+    /// @brief level of a line without hysteresis
+    constexpr LineLevel classify_level(uint16_t millivolts) {
+        if (millivolts < QC_LEVEL_MID_MV) { return LineLevel::V0; }
+        if (millivolts < QC_LEVEL_HIGH_MV) { return LineLevel::V0_6; }
+        return LineLevel::V3_3;
+    }
+
+    /// @brief level of a line, boundaries next to the previous level are moved away from it by the hysteresis
+    constexpr LineLevel classify_level(uint16_t millivolts, LineLevel previous) {
+        uint16_t mid = previous == LineLevel::V0 ?
+            QC_LEVEL_MID_MV + QC_LEVEL_HYSTERESIS_MV : QC_LEVEL_MID_MV - QC_LEVEL_HYSTERESIS_MV;
+        uint16_t high = previous == LineLevel::V3_3 ?
+            QC_LEVEL_HIGH_MV - QC_LEVEL_HYSTERESIS_MV : QC_LEVEL_HIGH_MV + QC_LEVEL_HYSTERESIS_MV;
+
+        if (millivolts < mid) { return LineLevel::V0; }
+        if (millivolts < high) { return LineLevel::V0_6; }
+        return LineLevel::V3_3;
+    }
+
+    /// @brief QC2.0 mode requested by given levels (D+/D- table in quick_charge.cpp), anything outside the table is a generic 5v sink
+    constexpr ChargingModes mode_from_levels(LineLevel dp, LineLevel dm) {
+        if (dp == LineLevel::V0) {
+            return dm == LineLevel::V0 ? ChargingModes::NotConnected : ChargingModes::GEN_5v;
+        }
+        if (dp == LineLevel::V0_6) {
+            switch (dm) {
+            case LineLevel::V0: return ChargingModes::QC_5v;
+            case LineLevel::V0_6: return ChargingModes::QC_12v;
+            case LineLevel::V3_3: return ChargingModes::QC_Var;
+            }
+        }
+        switch (dm) {
+        case LineLevel::V0_6: return ChargingModes::QC_9v;
+        case LineLevel::V3_3: return ChargingModes::QC_20v;
+        default: return ChargingModes::GEN_5v;
+        }
+    }
+
+    /// @brief QC2.0 mode requested by given line voltages, integer only
+    constexpr ChargingModes mode_from_millivolts(uint16_t dp, uint16_t dm) {
+        return mode_from_levels(classify_level(dp), classify_level(dm));
+    }
+
+    /// @brief Follows D+/D- of a sink connected to our port.
+    /// Levels are classified with hysteresis and a mode is reported only after it was stable for the debounce time,
+    /// so a change is reported at most debounce time + one sample period after the sink made it.
+    class QcSinkDetector {
+    private:
+        uint32_t _bc_done_us;
+        uint32_t _debounce_us;
+
+        LineLevel _dp, _dm;
+        /// @brief D+ is at 0.6v since _bc_since
+        bool _bc_timing;
+        uint64_t _bc_since;
+        /// @brief sink held D+ at 0.6v long enough, QC requests are accepted
+        bool _bc_done;
+        /// @brief D- was seen at 0v after BC done, so the data line short is open
+        bool _short_open;
+
+        ChargingModes _mode;
+        ChargingModes _candidate;
+        uint64_t _candidate_since;
+
+    public:
+        /// @param bc_done_us time D+ has to stay at 0.6v before the sink counts as QC (T_GLITCH_BC_DONE)
+        /// @param debounce_us time a new request has to stay on the lines (T_GLITCH_V_CHANGE)
+        QcSinkDetector(uint32_t bc_done_us, uint32_t debounce_us);
+
+        /// @brief forget the sink, e.g. after output was switched off
+        void reset();
+
+        /// @brief feed one measurement of both lines
+        /// @param now time of the measurement in microseconds (time_us_64)
+        /// @return true if reported mode changed
+        bool update(uint16_t dp_millivolts, uint16_t dm_millivolts, uint64_t now);
+
+        /// @brief debounced mode the sink requests, GEN_5v until it finishes the QC handshake
+        ChargingModes get_mode() const { return _mode; }
+
+        /// @brief has the sink finished the QC handshake
+        bool is_qc() const { return _bc_done; }
+    };
+}
@@ -1,165 +1,391 @@
 #include "quick_charge.h"
 
+#include "../logging/log.h"
+
 using namespace charging_protocols;
 
-DigitalPin::DigitalPin(uint8_t high, uint8_t low) {
-    _high = high;
-    _low = low;
-    gpio_init(_high);
-    gpio_init(_low);
-    // setting up pulls, else it won't work
-    gpio_pull_down(_high);
-    gpio_pull_down(_low);
+// continuous mode planner picks the quicker of a pulse train and a jump through a fixed mode
+static_assert(plan_continuous(ChargingModes::QC_Var, 7000, 7400, QC3_CLASS_A_MAX_VOLTAGE_MV).via == ChargingModes::QC_Var);
+static_assert(plan_continuous(ChargingModes::QC_Var, 7000, 7400, QC3_CLASS_A_MAX_VOLTAGE_MV).pulses == 2);
+static_assert(plan_continuous(ChargingModes::QC_5v, 5000, 11800, QC3_CLASS_A_MAX_VOLTAGE_MV).via == ChargingModes::QC_12v);
+static_assert(plan_continuous(ChargingModes::QC_5v, 5000, 11800, QC3_CLASS_A_MAX_VOLTAGE_MV).pulses == -1);
+static_assert(plan_continuous(ChargingModes::QC_Var, 5000, 19000, QC3_CLASS_B_MAX_VOLTAGE_MV).via == ChargingModes::QC_20v);
+// 20v is out of class A, so it's never used as a shortcut
+static_assert(plan_continuous(ChargingModes::QC_12v, 12000, 11900, QC3_CLASS_A_MAX_VOLTAGE_MV).via == ChargingModes::QC_12v);
+// off-grid targets end on the step below, from either side
+static_assert(plan_continuous(ChargingModes::QC_Var, 12000, 11900, QC3_CLASS_A_MAX_VOLTAGE_MV).pulses == -1);
+static_assert(plan_continuous(ChargingModes::QC_Var, 11800, 11900, QC3_CLASS_A_MAX_VOLTAGE_MV).pulses == 0);
+static_assert(step_floor(9100) == 9000);
+
+QuickChargePort_alt::QuickChargePort_alt(DataLines* lines) :
+    _lines(lines),
+    _detector(QC_T_GLITCH_BC_DONE_MS * 1000, QC_T_GLITCH_V_CHANGE_MIN_MS * 1000)
+{
+    _mode = ChargingModes::NotConnected;
+    _handshake_done = false;
+    _qc_input = false;
+    _is_input = true;
+    _millivolt_estimated = 0;
+    _faults = PORT_FAULT_NONE;
+    _millivolt_target = 0;
+    _has_target = false;
+    _class = QcClass::A;
+    _millivolt_limit = QC3_CLASS_B_MAX_VOLTAGE_MV;
+    _pulse_up = false;
+    _train_length = 0;
+    _state = QcState::Idle;
+    _deadline = 0;
+    _pending_mode = ChargingModes::NotConnected;
+    _has_pending = false;
+    _sampler = nullptr;
+    _adc_dp = 0;
+    _adc_dm = 0;
 }
 
-void DigitalPin::set_hiz() {
-    gpio_set_dir(_high, false);
-    gpio_set_dir(_low, false);
+PortState QuickChargePort_alt::get_state() const {
+    if (!_is_input) {
+        // sink's pulses aren't followed, continuous mode voltage is unknown
+        return { mode_millivolts(_mode), _mode, _detector.is_qc(), _faults };
+    }
+    return { _millivolt_estimated, _mode, _qc_input, _faults };
 }
 
-void DigitalPin::set_0v() {
-    gpio_set_dir(_high, true);
-    gpio_set_dir(_low, true);
-    gpio_put(_high, false);
-    gpio_put(_low, false);
+bool QuickChargePort_alt::output_handshake() {
+    return !_is_input && _detector.is_qc();
 }
 
-void DigitalPin::set_600mv() {
-    gpio_set_dir(_high, true);
-    gpio_set_dir(_low, true);
-    gpio_put(_high, true);
-    gpio_put(_low, false);
+void QuickChargePort_alt::begin_output(const sensors::AdcSampler* sampler, uint8_t adc_dp, uint8_t adc_dm) {
+    if (!sampler->is_sampled(adc_dp) || !sampler->is_sampled(adc_dm)) {
+        LOG_ERROR("D+/D- adc %d/%d is not sampled, port stays input\n", adc_dp, adc_dm);
+        return;
+    }
+
+    _is_input = false;
+    _sampler = sampler;
+    _adc_dp = adc_dp;
+    _adc_dm = adc_dm;
+    _has_pending = false;
+    _state = QcState::Idle;
+
+    // sink drives the lines, we only listen
+    _lines->drive(LineDrive::HiZ, LineDrive::HiZ);
+    _detector.reset();
+    _mode = limited(_detector.get_mode());
 }
 
-void DigitalPin::set_2700mv() {
-    gpio_set_dir(_high, true);
-    gpio_set_dir(_low, true);
-    gpio_put(_high, false);
-    gpio_put(_low, true);
+void QuickChargePort_alt::enter(QcState state, uint64_t now, uint64_t wait_us) {
+    _state = state;
+    _deadline = now + wait_us;
 }
 
-void DigitalPin::set_3300mv() {
-    gpio_set_dir(_high, true);
-    gpio_set_dir(_low, true);
-    gpio_put(_high, true);
-    gpio_put(_low, true);
+void QuickChargePort_alt::hold(QcState state, uint64_t now, uint64_t wait_us) {
+    if (_lines->hold(wait_us)) { wait_us = 0; }
+    enter(state, now, wait_us);
 }
 
-bool DigitalPin::read_high() {
-    return gpio_get(_high);
+void QuickChargePort_alt::begin() {
+    _handshake_done = false;
+    _qc_input = false;
+    _mode = ChargingModes::NotConnected;
+
+    _lines->drive(LineDrive::V3_3, LineDrive::HiZ);
+    enter(QcState::DetectShort, time_us_64(), QC_T_LINE_SETTLE_US);
 }
 
-bool DigitalPin::read_low() {
-    return gpio_get(_low);
+bool QuickChargePort_alt::is_busy() const {
+    return _state != QcState::Idle && _state != QcState::Generic && _state != QcState::Ready;
 }
 
+bool QuickChargePort_alt::poll(uint64_t now) {
+    if (!_is_input) {
+        uint16_t dp = _sampler->average(_adc_dp, QC_OUTPUT_AVERAGE_SAMPLES) * 3300 / 4096;
+        uint16_t dm = _sampler->average(_adc_dm, QC_OUTPUT_AVERAGE_SAMPLES) * 3300 / 4096;
+        if (!_detector.update(dp, dm, now)) { return false; }
 
-QuickChargePort_alt::QuickChargePort_alt(DigitalPin dm, DigitalPin dp) :
-    _dm(dm),
-    _dp(dp)
-{
-    _mode = ChargingModes::NotConnected;
+        ChargingModes requested = _detector.get_mode();
+        LOG_INFO("sink requests %s\n", ChargingModes_string[int(requested)]);
+        ChargingModes previous = _mode;
+        _mode = limited(requested);
+        return _mode != previous;
+    }
+
+    if (now < _deadline || _lines->is_busy()) { return false; }
+    ChargingModes previous = _mode;
+
+    switch (_state) {
+    case QcState::DetectShort: {
+        bool shorted = _lines->read_dm();
+        if (!shorted) {                     // are D+ & D- disconnected?
+            // no adapter, or one that doesn't talk on D+/D- at all, both look the same
+            _lines->drive(LineDrive::HiZ, LineDrive::HiZ);
+            _qc_input = false;
+            _mode = ChargingModes::NotConnected;
+            _millivolt_estimated = 0;
+            if (!_handshake_done || previous != _mode) { LOG_INFO("no adapter detected\n"); }
+            _handshake_done = true;
+            enter(QcState::Generic, now, QC_T_REPROBE_US);
+            break;
+        }
+        if (previous == ChargingModes::GEN_5v) {
+            // generic adapter is still there, it doesn't get a second handshake
+            _lines->drive(LineDrive::HiZ, LineDrive::HiZ);
+            enter(QcState::Generic, now, QC_T_REPROBE_US);
+            break;
+        }
+        if (_handshake_done) { LOG_INFO("adapter connected\n"); }
+        // setting 600mv at D+ for adapter to start handshake, then wait for adapter to disconnect D+ & D-
+        _lines->drive(LineDrive::V0_6, LineDrive::HiZ);
+        hold(QcState::WaitBcDone, now, QC_T_GLITCH_BC_DONE_MS * 1000);
+        break;
+    }
+    case QcState::WaitBcDone: {
+        _lines->drive(LineDrive::V3_3, LineDrive::HiZ);    // setting D+ to 3.3v to check if pins are connected
+        enter(QcState::ConfirmShort, now, QC_T_LINE_SETTLE_US);
+        break;
+    }
+    case QcState::ConfirmShort: {
+        _handshake_done = true;
+        if (!_lines->read_dm()) {           // are D+ & D- disconnected?
+            _qc_input = true;               // adapter has disconnected D+ & D- so QC2.0+ is supported
+            LOG_INFO("adapter is QC2.0+ compliant\n");
+            if (!_has_pending) {
+                _pending_mode = ChargingModes::QC_5v;
+                _has_pending = true;
+            }
+            _state = QcState::Ready;
+            break;
+        }
+        // after handshake tries D+ & D- are still connected, so it's generic 5V 2A
+        _lines->drive(LineDrive::HiZ, LineDrive::HiZ);
+        _qc_input = false;
+        _mode = ChargingModes::GEN_5v;
+        _millivolt_estimated = mode_millivolts(_mode);
+        enter(QcState::Generic, now, QC_T_REPROBE_US);
+        LOG_INFO("adapter is not QC2.0+ compliant\n");
+        break;
+    }
+    case QcState::PulseActive: {
+        // line goes back to continuous mode level, adapter counts the pulse on this edge
+        _lines->drive(LineDrive::V0_6, LineDrive::V3_3);
+        _millivolt_estimated += _pulse_up ? QC3_STEP_MV : -QC3_STEP_MV;
+        enter(QcState::PulseInactive, now, QC_T_INACTIVE_MS * 1000);
+        break;
+    }
+    case QcState::PulseTrain:
+        // data lines have sent the whole train by now
+        _millivolt_estimated += (_pulse_up ? QC3_STEP_MV : -QC3_STEP_MV) * _train_length;
+        [[fallthrough]];
+    case QcState::PulseInactive:
+    case QcState::ModeHold:
+    case QcState::Ready: {
+        if (!_has_pending && step_to_target(now)) { break; }
+        if (!_has_pending) {
+            _state = QcState::Ready;
+            break;
+        }
+        // both lines change in one step, so there's no in-between mode to release them for
+        _has_pending = false;
+        apply_mode(_pending_mode);
+        // adapter ignores further changes until its glitch filter passes
+        hold(QcState::ModeHold, now, QC_T_GLICH_V_CHANGE_MS * 1000);
+        break;
+    }
+    case QcState::Generic: {
+        // D+ at 3.3v again, a short to D- means an adapter was plugged in or is still there
+        _lines->drive(LineDrive::V3_3, LineDrive::HiZ);
+        enter(QcState::DetectShort, now, QC_T_LINE_SETTLE_US);
+        break;
+    }
+    case QcState::Idle:
+        break;
+    }
+    return _mode != previous;
 }
 
-bool QuickChargePort_alt::output_handshake() {
-    return true;
+bool QuickChargePort_alt::is_qc() {
+    return this->_qc_input;
 }
-void QuickChargePort_alt::begin() {
-    _dp.set_hiz();
-    _dm.set_hiz();
-
-    _dp.set_3300mv();
-    sleep_us(10); // short delay
-    if (!_dm.read_high()) {             // are D+ & D- disconnected?
-        _dp.set_hiz();
-        _qc_input = false;              // adapter is generic 5v
-        _mode = ChargingModes::GEN_5v;
-        _qc_input = false;
-        printf("adapter is not QC2.0+ compliant\n");
+
+void QuickChargePort_alt::request(ChargingModes mode) {
+    if (_handshake_done && !_qc_input) {
+        LOG_WARN("tried to set QC2.0+ mode when charger is not QC2.0+ compliant\n");
+        return;
+    }
+    if (mode == ChargingModes::NotConnected) {
+        LOG_WARN("tried changing mode while device is disconnected\n");
+        return;
+    }
+    if (mode_millivolts(mode) > max_millivolts()) {
+        LOG_WARN("mode %s is above limit of the adapter class\n", ChargingModes_string[int(mode)]);
         return;
     }
 
-    // QC should be 
-    _dp.set_600mv();                    // setting 600mv at D+ for adapter to start handshake
-    sleep_ms(QC_T_GLITCH_BC_DONE_MS);   // waiting for adapter to disconnect D+ & D-
+    _pending_mode = mode;
+    _has_pending = true;
+    _has_target = false;
+}
 
-    _dp.set_3300mv();                   // setting D+ to 3.3v to check if pins are connected
-    sleep_us(10);
-    if (!_dm.read_high()) {             // are D+ & D- disconnected?
-        this->request(ChargingModes::QC_5v);
-        _mode = ChargingModes::QC_5v;
-        _qc_input = true;               // adapter has disconnected D+ & D- so QC2.0+ is supported
-        printf("adapter is QC2.0+ compliant\n");
+void QuickChargePort_alt::request_millivolts(uint16_t millivolts) {
+    if (_handshake_done && !_qc_input) {
+        LOG_WARN("tried to set QC3.0 voltage when charger is not QC2.0+ compliant\n");
+        return;
+    }
+    if (_faults & PORT_FAULT_PANIC) {
+        LOG_WARN("port is in panic, it stays at 5v\n");
         return;
     }
 
-    // after handshake tries D+ & D- are still connected, so it's generic 5V 2A
-    _dp.set_hiz();
-    _dm.set_hiz();
-    _qc_input = false;
-    _mode = ChargingModes::GEN_5v;
-    printf("adapter is not QC2.0+ compliant\n");
-    return;
+    if (millivolts < QC3_MIN_VOLTAGE_MV) { millivolts = QC3_MIN_VOLTAGE_MV; }
+    if (millivolts > max_millivolts()) { millivolts = max_millivolts(); }
 
+    _millivolt_target = step_floor(millivolts);
+    _has_target = true;
 }
-bool QuickChargePort_alt::is_qc() {
-    return this->_qc_input;
+
+void QuickChargePort_alt::set_class(QcClass qc_class) {
+    _class = qc_class;
+    if (_has_target && _millivolt_target > max_millivolts()) {
+        _millivolt_target = step_floor(max_millivolts());
+    }
 }
 
-void QuickChargePort_alt::request(ChargingModes mode) {
-    if (!_qc_input) {
-        printf("tried to set QC2.0+ mode when charger is not QC2.0+ compliant\n");
+uint16_t QuickChargePort_alt::max_millivolts() const {
+    if (_faults & PORT_FAULT_PANIC) { return mode_millivolts(ChargingModes::QC_5v); }
+    uint16_t class_max = _class == QcClass::B ? QC3_CLASS_B_MAX_VOLTAGE_MV : QC3_CLASS_A_MAX_VOLTAGE_MV;
+    return _millivolt_limit < class_max ? _millivolt_limit : class_max;
+}
+
+ChargingModes QuickChargePort_alt::limited(ChargingModes mode) const {
+    uint16_t millivolts = mode_millivolts(mode);
+    // sink's continuous mode isn't followed, it may be anywhere up to the class limit
+    if (!_is_input && mode == ChargingModes::QC_Var) {
+        millivolts = _class == QcClass::B ? QC3_CLASS_B_MAX_VOLTAGE_MV : QC3_CLASS_A_MAX_VOLTAGE_MV;
+    }
+    if (millivolts <= max_millivolts()) { return mode; }
+
+    const ChargingModes fixed[] = { ChargingModes::QC_12v, ChargingModes::QC_9v, ChargingModes::QC_5v };
+    for (ChargingModes lower : fixed) {
+        if (mode_millivolts(lower) <= max_millivolts()) { return lower; }
+    }
+    return ChargingModes::QC_5v;
+}
+
+void QuickChargePort_alt::enforce_limit() {
+    if (!_is_input) {
+        ChargingModes mode = limited(_detector.get_mode());
+        if (mode != _mode) {
+            _mode = mode;
+            LOG_INFO("output limited to %s\n", ChargingModes_string[int(_mode)]);
+        }
+        return;
+    }
+    if (!_qc_input) { return; }
+
+    uint16_t max = max_millivolts();
+    if (_has_target && _millivolt_target > max) { _millivolt_target = step_floor(max); }
+    if (_has_pending) { _pending_mode = limited(_pending_mode); }
+    if (_has_target || _has_pending || _millivolt_estimated <= max) { return; }
+
+    // nothing queued would bring the output down, so queue it here
+    if (_mode == ChargingModes::QC_Var) {
+        _millivolt_target = max < QC3_MIN_VOLTAGE_MV ? QC3_MIN_VOLTAGE_MV : step_floor(max);
+        _has_target = true;
+    }
+    else {
+        _pending_mode = limited(_mode);
+        _has_pending = true;
+    }
+}
+
+void QuickChargePort_alt::set_voltage_limit(uint16_t millivolts) {
+    // 5v is always allowed, it's where every port starts
+    if (millivolts < mode_millivolts(ChargingModes::QC_5v)) { millivolts = mode_millivolts(ChargingModes::QC_5v); }
+    _millivolt_limit = millivolts;
+    enforce_limit();
+}
+
+void QuickChargePort_alt::panic() {
+    LOG_ERROR("port panic, falling back to 5v\n");
+    _faults |= PORT_FAULT_PANIC;
+
+    // continuous mode leaves the output where it is, fixed 5v is the quickest way down
+    _has_target = false;
+    if (_is_input && _qc_input) {
+        _pending_mode = ChargingModes::QC_5v;
+        _has_pending = true;
         return;
     }
+    enforce_limit();
+}
+
+/// @brief start a pulse or queue a mode change that brings output closer to the target
+/// @return true if a pulse was started, a mode change is left in _pending_mode
+bool QuickChargePort_alt::step_to_target(uint64_t now) {
+    if (!_has_target || !_qc_input) { return false; }
+
+    ContinuousPlan plan = plan_continuous(_mode, _millivolt_estimated, _millivolt_target, max_millivolts());
+    if (plan.via != ChargingModes::QC_Var) {
+        // jump to the fixed mode first, continuous mode is entered from there
+        _pending_mode = plan.via == _mode ? ChargingModes::QC_Var : plan.via;
+        _has_pending = true;
+        return false;
+    }
+    if (plan.pulses == 0) {
+        _has_target = false;
+        LOG_INFO("continuous mode reached %umV\n", (unsigned)_millivolt_estimated);
+        return false;
+    }
+
+    // increment: D+ 0.6v -> 3.3v, decrement: D- 3.3v -> 0.6v
+    _pulse_up = plan.pulses > 0;
+    _train_length = _pulse_up ? plan.pulses : -plan.pulses;
+    // whole train at once if the data lines time it, active & inactive times are the same
+    static_assert(QC_T_ACTIVE_MS == QC_T_INACTIVE_MS, "pulse trains have a single hold time");
+    LineDrive active = _pulse_up ? LineDrive::V3_3 : LineDrive::V0_6;
+    if (_lines->pulses(active, active, LineDrive::V0_6, LineDrive::V3_3, _train_length, QC_T_ACTIVE_MS * 1000)) {
+        enter(QcState::PulseTrain, now, 0);
+        return true;
+    }
+    _lines->drive(active, active);
+    enter(QcState::PulseActive, now, QC_T_ACTIVE_MS * 1000);
+    return true;
+}
 
-    _dp.set_hiz();
-    _dm.set_hiz();
-    sleep_us(10);
+void QuickChargePort_alt::apply_mode(ChargingModes mode) {
     switch (mode) {
     case ChargingModes::QC_5v: {
-        _dp.set_600mv();
-        _dm.set_0v();
+        _lines->drive(LineDrive::V0_6, LineDrive::V0);
         _mode = ChargingModes::QC_5v;
         break;
     }
     case ChargingModes::QC_9v: {
-        _dp.set_3300mv();
-        _dm.set_600mv();
+        _lines->drive(LineDrive::V3_3, LineDrive::V0_6);
         _mode = ChargingModes::QC_9v;
         break;
     }
     case ChargingModes::QC_12v: {
-        _dp.set_600mv();
-        _dm.set_600mv();
+        _lines->drive(LineDrive::V0_6, LineDrive::V0_6);
         _mode = ChargingModes::QC_12v;
         break;
     }
     case ChargingModes::QC_20v: {
-        _dp.set_3300mv();
-        _dm.set_3300mv();
+        _lines->drive(LineDrive::V3_3, LineDrive::V3_3);
         _mode = ChargingModes::QC_20v;
         break;
     }
     case ChargingModes::QC_Var: {
-        _dp.set_600mv();
-        _dm.set_3300mv();
+        _lines->drive(LineDrive::V0_6, LineDrive::V3_3);
+        // output stays where the previous mode left it
         _mode = ChargingModes::QC_Var;
         break;
     }
-    case ChargingModes::NotConnected: {
-        printf("tried changing mode while device is disconnected\n");
-        break;
-    }
-    default: printf("unknown charging mode requested, nothing changed\n");
+    default: LOG_WARN("unknown charging mode requested, nothing changed\n");
     }
+    if (_mode != ChargingModes::QC_Var) { _millivolt_estimated = mode_millivolts(_mode); }
 
-    printf("setting charging mode to %s\n", ChargingModes_string[int(_mode)]);
+    LOG_INFO("setting charging mode to %s\n", ChargingModes_string[int(_mode)]);
 
-    // lag before setting pins to hiz
-    // apparently voltage should just remain 
-    // sleep_ms(QC_T_GLICH_V_CHANGE_MS);
-    // _dp.set_0v();
-    // _dm.set_0v();
+    // apparently voltage should just remain, lines aren't released after the change
 }
 
 /*
@@ -171,16 +397,28 @@ void QuickChargePort_alt::request(ChargingModes mode) {
        | 0.6V | 3.3V | VARIABLE |
 */
 
+/// @brief single conversion on given ADC input
+/// @param adc ADC input 0-3
+/// @return voltage in V
+float QuickChargePort_alt::get_voltage(uint adc) {
+    // round robin of a running sampler would lose its channel order
+    hard_assert(!sensors::AdcSampler::is_adc_owned());
+    adc_select_input(adc);
+    return adc_read() * ADC_CONVERSION_FACTOR;
+}
+
 /// @brief read input of the USB port to check what QC mode is being requested
 /// @param adc_dp ADC that D+ pin is connected to
 /// @param adc_dm ADC that D- pin is connected to
 /// @return requested charging mode
 ChargingModes QuickChargePort_alt::get_charging_mode(uint8_t adc_dp, uint8_t adc_dm) {
-    float dp = get_voltage(adc_dp);
-    float dm = get_voltage(adc_dm);
-    sleep_ms(QC_T_GLITCH_BC_DONE_MS);
+    hard_assert(!sensors::AdcSampler::is_adc_owned());
+    adc_select_input(adc_dp);
+    uint16_t dp = adc_read() * 3300 / 4096;
+    adc_select_input(adc_dm);
+    uint16_t dm = adc_read() * 3300 / 4096;
 
-    return mode_from_voltage(dp, dm);
+    return mode_from_millivolts(dp, dm);
 }
 
 
@@ -192,31 +430,11 @@ ChargingModes QuickChargePort_alt::get_charging_mode(uint8_t adc_dp, uint8_t adc
 /// @param dm voltage at D- pin
 /// @return mode if it was possible to match
 ChargingModes QuickChargePort_alt::mode_from_voltage(float dp, float dm) {
-    // TODO: measure voltage on pins when port isn't connected
-    if (dp == 0. && dm == 0.) {
-        return ChargingModes::NotConnected;
-    }
+    // lines can't leave 0-5v, clamping keeps the conversion in range
+    if (dp < 0.f) { dp = 0.f; }
+    if (dm < 0.f) { dm = 0.f; }
+    if (dp > 5.f) { dp = 5.f; }
+    if (dm > 5.f) { dm = 5.f; }
 
-    if (0.2 < dp < 1.) {
-        if (dm < .2) {
-            return ChargingModes::QC_5v;
-        }
-        else if (.2 < dm < 1.) {
-            return ChargingModes::QC_12v;
-        }
-        else if (2.9 < dm < 3.6) {
-            return ChargingModes::QC_Var;
-        }
-    }
-
-    else if (2.9 < dp < 3.6) {
-        if (.2 < dm < 1.) {
-            return ChargingModes::QC_12v;
-        }
-        else if (2.9 < dm < 3.6) {
-            return ChargingModes::QC_20v;
-        }
-    }
-    // couldn't match charging mode 
-    return ChargingModes::GEN_5v;
+    return mode_from_millivolts(dp * 1000.f, dm * 1000.f);
 }
@@ -5,78 +5,245 @@
 #include "pico/stdlib.h"
 #include "hardware/adc.h"
 
+#include "charging_modes.h"
+#include "port_state.h"
+#include "qc_sink_detector.h"
+#include "data_lines.h"
+#include "../sensors/adc_sampler.h"
+
 #define QC3_MIN_VOLTAGE_MV              3600
 #define QC3_CLASS_A_MAX_VOLTAGE_MV      12000
 #define QC3_CLASS_B_MAX_VOLTAGE_MV      20000
+// one continuous mode pulse moves the adapter output by this much
+#define QC3_STEP_MV                     200
 
 // timing values for Portable Device are not available, indicative values for a HVDCP charger were taken from the uP7104 datasheet
 #define QC_T_GLITCH_BC_DONE_MS          1500
 #define QC_T_GLICH_V_CHANGE_MS          60
 #define QC_T_ACTIVE_MS                  1
 #define QC_T_INACTIVE_MS                1
+// time for D+/D- levels to settle before they're read back or changed again
+#define QC_T_LINE_SETTLE_US             10
+// input without an adapter, or with a plain BC1.2 one, checks D+/D- for a change this often
+#define QC_T_REPROBE_US                 (1000 * 1000)
+// source side: a new request has to stay on the lines at least this long, QC2.0 allows 20-60ms
+#define QC_T_GLITCH_V_CHANGE_MIN_MS     20
+// ADC samples averaged into one D+/D- measurement of an output port
+#define QC_OUTPUT_AVERAGE_SAMPLES       4
 
-#define ADC_CONVERSION_FACTOR (3.3f / (1 << 12)); // for 3.3v load in 12 bits
-
-/// @brief Possible configurations for QC both input & output
-enum class ChargingModes {
-    GEN_5v,
-    QC_5v,
-    QC_9v,
-    QC_12v,
-    QC_20v,
-    QC_Var,
-    NotConnected
-};
-
-static const char* ChargingModes_string[] = {
-    "GEN_5v",
-    "QC_5v",
-    "QC_9v",
-    "QC_12v",
-    "QC_20v",
-    "QC_Var",
-    "NotConnected"
-};
+#define ADC_CONVERSION_FACTOR (3.3f / (1 << 12)) // for 3.3v load in 12 bits
 
 namespace charging_protocols {
+    /// @brief QC3.0 adapter class, limits the highest voltage that may be requested
+    enum class QcClass {
+        A,      // up to 12V
+        B       // up to 20V
+    };
 
+    /// @brief output voltage of a fixed mode in mV, 0 for variable modes & NotConnected
+    constexpr uint16_t mode_millivolts(ChargingModes mode) {
+        switch (mode) {
+        case ChargingModes::GEN_5v:
+        case ChargingModes::QC_5v:
+        case ChargingModes::PD_5v: return 5000;
+        case ChargingModes::QC_9v:
+        case ChargingModes::PD_9v: return 9000;
+        case ChargingModes::QC_12v:
+        case ChargingModes::PD_12v: return 12000;
+        case ChargingModes::QC_20v:
+        case ChargingModes::PD_20v: return 20000;
+        default: return 0;
+        }
+    }
 
-    class DigitalPin {
-    private:
-        uint8_t _high, _low;
-    public:
-        DigitalPin(uint8_t high, uint8_t low);
-        void set_hiz();
-        void set_0v();
-        void set_600mv();
-        void set_2700mv();
-        void set_3300mv();
-
-        bool read_high();
-        bool read_low();
+    /// @brief highest continuous mode voltage not above given one, pulses only reach multiples of QC3_STEP_MV
+    constexpr uint16_t step_floor(uint16_t millivolts) {
+        return millivolts - millivolts % QC3_STEP_MV;
+    }
+
+    /// @brief how to reach a continuous mode voltage: switch to `via` first (QC_Var if already there),
+    /// then enter continuous mode and send `pulses` (negative ones are decrements)
+    struct ContinuousPlan {
+        ChargingModes via;
+        int16_t pulses;
+    };
+
+    /// @brief Quickest way from current output to target. Entering QC_Var keeps the previous voltage,
+    /// so jumping to the nearest fixed mode first is often faster than a long pulse train.
+    /// @param mode mode that is applied now
+    /// @param millivolts output voltage now
+    /// @param target wanted voltage, has to be within limits of the adapter class. Pulses never go past it, a target
+    /// off the QC3_STEP_MV grid ends on the step below
+    /// @param max_millivolts highest voltage of the adapter class
+    constexpr ContinuousPlan plan_continuous(ChargingModes mode, uint16_t millivolts, uint16_t target, uint16_t max_millivolts) {
+        // costs in microseconds
+        const uint32_t pulse_us = (QC_T_ACTIVE_MS + QC_T_INACTIVE_MS) * 1000;
+        const uint32_t change_us = QC_T_GLICH_V_CHANGE_MS * 1000;
+
+        // rounded down, so output never ends above the target
+        auto pulses_between = [](uint16_t from, uint16_t to) -> int16_t {
+            int32_t diff = (int32_t)to - from;
+            return diff >= 0 ? diff / QC3_STEP_MV : -((-diff + QC3_STEP_MV - 1) / QC3_STEP_MV);
+        };
+
+        ContinuousPlan best = { ChargingModes::QC_Var, 0 };
+        uint32_t best_cost = UINT32_MAX;
+        if (mode == ChargingModes::QC_Var) {
+            best.pulses = pulses_between(millivolts, target);
+            best_cost = (best.pulses < 0 ? -best.pulses : best.pulses) * pulse_us;
+        }
+
+        const ChargingModes fixed[] = { ChargingModes::QC_5v, ChargingModes::QC_9v, ChargingModes::QC_12v, ChargingModes::QC_20v };
+        for (ChargingModes via : fixed) {
+            if (mode_millivolts(via) > max_millivolts) { continue; }
+
+            int16_t pulses = pulses_between(mode_millivolts(via), target);
+            // switching to the fixed mode (if needed) & to continuous mode wait for glitch filter each
+            uint32_t cost = (via == mode ? 0 : change_us) + change_us + (pulses < 0 ? -pulses : pulses) * pulse_us;
+            if (cost < best_cost) {
+                best = { via, pulses };
+                best_cost = cost;
+            }
+        }
+        return best;
+    }
+
+    /// @brief steps of the input handshake & mode changes, advanced by QuickChargePort_alt::poll()
+    enum class QcState {
+        Idle,
+        DetectShort,        // D+ at 3.3v, waiting for D- to follow
+        WaitBcDone,         // D+ at 600mv, waiting for adapter to open D+/D- short
+        ConfirmShort,       // D+ at 3.3v again, checking the short is gone
+        Generic,            // no adapter or a generic 5v one, D+/D- short is checked again now & then
+        Ready,              // QC adapter, waiting for requests
+        ModeHold,           // new mode is applied, adapter is filtering glitches
+        PulseActive,        // continuous mode, one line is moved for an increment/decrement pulse
+        PulseInactive,      // continuous mode, line is back, adapter needs a gap before next pulse
+        PulseTrain          // continuous mode, data lines send all pulses on their own
     };
 
     class QuickChargePort_alt {
     private:
-        DigitalPin _dp, _dm;
+        DataLines* _lines;
         ChargingModes _mode;
         bool _handshake_done, _qc_input, _is_input;
-        double _millivolt_estimated;
+        /// @brief output voltage of the adapter, it's not measured, just followed through requests & pulses
+        uint16_t _millivolt_estimated;
+        /// @brief PortFault flags
+        uint8_t _faults;
+
+        /// @brief current step of the handshake
+        QcState _state;
+        /// @brief time in microseconds at which current step ends
+        uint64_t _deadline;
+        /// @brief mode requested, applied once the port is Ready
+        ChargingModes _pending_mode;
+        bool _has_pending;
+
+        /// @brief continuous mode voltage requested, it's tracked once the port is Ready
+        uint16_t _millivolt_target;
+        bool _has_target;
+        QcClass _class;
+        /// @brief highest voltage allowed by the power budget, on top of the adapter class
+        uint16_t _millivolt_limit;
+        /// @brief direction of the pulse in progress
+        bool _pulse_up;
+        /// @brief pulses of the train in progress
+        uint16_t _train_length;
+
+        /// @brief output only: follows requests of the connected sink
+        QcSinkDetector _detector;
+        /// @brief output only: background samples of D+/D-
+        const sensors::AdcSampler* _sampler;
+        uint8_t _adc_dp, _adc_dm;
+
+        /// @brief move to next step, it ends after `wait_us`
+        void enter(QcState state, uint64_t now, uint64_t wait_us);
+        /// @brief same as enter(), but lines are held by the data lines driver if it can time them
+        void hold(QcState state, uint64_t now, uint64_t wait_us);
+        /// @brief set D+/D- to levels of a QC2.0 mode
+        void apply_mode(ChargingModes mode);
+        /// @brief start next step towards target voltage, false if there's nothing to do
+        bool step_to_target(uint64_t now);
+        uint16_t max_millivolts() const;
+        /// @brief highest mode not above max_millivolts(), given mode if it's within it.
+        /// Continuous mode of an input is kept, its voltage is limited through the target. A sink's continuous mode
+        /// counts as the class limit, below that it gets the highest fixed mode allowed
+        ChargingModes limited(ChargingModes mode) const;
+        /// @brief bring requests & applied output under max_millivolts(), it's stepped down by poll()
+        void enforce_limit();
     public:
         /// @brief main contructor
-        /// @param dp DigitalPin that is connected to D+
-        /// @param dm DigitalPin that is connected to D-
-        QuickChargePort_alt(DigitalPin dp, DigitalPin dm);
+        /// @param lines D+ & D- of the port, e.g. SioDataLines or PioDataLines
+        QuickChargePort_alt(DataLines* lines);
 
-        /// @brief commit handshake to input voltage
+        /// @brief start handshake to input voltage, it's carried out by poll(). Port is NotConnected while no adapter
+        /// shorts D+/D-, poll() keeps looking and runs the handshake once one is plugged in. A QC adapter that's
+        /// unplugged can't be told apart from one that's still there, begin() starts over
         void begin();
-        /// @brief commit handshake to output voltage
-        /// @return is device QC compliant
+
+        /// @brief act as QC source: lines are released and the sink's requests are followed with poll()
+        /// @param sampler running sampler that samples both ADC inputs
+        /// @param adc_dp ADC input connected to D+
+        /// @param adc_dm ADC input connected to D-
+        void begin_output(const sensors::AdcSampler* sampler, uint8_t adc_dp, uint8_t adc_dm);
+
+        /// @brief advance handshake & pending mode change, or follow the sink on an output port. Never blocks
+        /// @param now current time in microseconds (time_us_64)
+        /// @return true if mode of the port changed
+        bool poll(uint64_t now);
+
+        /// @brief is handshake or mode change in progress
+        bool is_busy() const;
+
+        /// @brief mode that is currently applied on the lines
+        ChargingModes get_mode() const { return _mode; }
+
+        /// @brief state of the handshake on an output port, it's carried out by poll()
+        /// @return has the connected device finished QC handshake
         bool output_handshake();
 
-        /// @brief request given mode from power adapter
+        /// @brief request given mode from power adapter, it's applied by poll() once handshake is done.
+        /// Newer request replaces one that wasn't applied yet.
         /// @param mode mode to request
         void request(ChargingModes mode);
+
+        /// @brief request voltage in QC3.0 continuous mode, it's reached by poll() with the quickest mix
+        /// of a fixed mode & 200mV pulses. Newer request replaces the old target, fixed mode requests cancel it.
+        /// @param millivolts wanted voltage, it's clamped to QC3_MIN_VOLTAGE_MV & limit of the adapter class
+        void request_millivolts(uint16_t millivolts);
+
+        /// @brief limit voltages to the given adapter class, class A is assumed until set
+        void set_class(QcClass qc_class);
+
+        /// @brief limit voltage of the port, e.g. from power budget. Input port steps down right away
+        /// and clamps later requests, requests aren't raised again when the limit goes up.
+        /// Output port applies the highest allowed mode, even if the sink asks for more
+        /// @param millivolts highest voltage, never below 5v
+        void set_voltage_limit(uint16_t millivolts);
+
+        uint16_t get_voltage_limit() const { return _millivolt_limit; }
+
+        /// @brief timed sequences of the data lines follow a new clk_sys frequency
+        void clock_changed() { _lines->clock_changed(); }
+
+        /// @brief mode the sink asks for on an output port, get_mode() is lower while it's above the limit.
+        /// Same as get_mode() on an input port
+        ChargingModes get_requested_mode() const { return _is_input ? _mode : _detector.get_mode(); }
+
+        /// @brief voltage the adapter should output by now, QC2.0 adapters ignore pulses so it's only valid for QC3.0
+        uint16_t get_millivolts_estimated() const { return _millivolt_estimated; }
+
+        /// @brief snapshot of the port for UI & telemetry, compare with the last one to see if anything changed
+        PortState get_state() const;
+
+        /// @brief set PortFault flags, they stay in the state until cleared
+        void set_fault(uint8_t faults) { _faults |= faults; }
+        void clear_fault(uint8_t faults) { _faults &= ~faults; }
+
+        /// @brief single conversion on given ADC input, not allowed while an AdcSampler is running
+        /// @param adc ADC input 0-3
+        /// @return voltage in V
         float get_voltage(uint adc);
 
         /// @brief check if adapter is QC2.0+ compliant
@@ -89,14 +256,17 @@ namespace charging_protocols {
         /// @return matching QC2.0 mode
         ChargingModes mode_from_voltage(float dp, float dm);
 
-        /// @brief get voltage on the port and return mode that is currently being requested
+        /// @brief get voltage on the port and return mode that is currently being requested, never blocks.
+        /// Single reading without debouncing, poll() of an output port should be preferred.
+        /// Not allowed while an AdcSampler is running, the sampler's inputs go to begin_output() instead
         /// @param adc_dp ADC connected to D+ pin 
         /// @param adc_dm ADC connected to D- pin
-        /// @return 
+        /// @return matching QC2.0 mode
         ChargingModes get_charging_mode(uint8_t adc_dp, uint8_t adc_dm);
 
 
-        // TODO: disable output and try setting input to 5v if possible
+        /// @brief emergency fallback to 5v: input asks the adapter for 5v, output applies 5v whatever the sink wants.
+        /// Port stays at 5v with PORT_FAULT_PANIC set until the fault is cleared & set_voltage_limit() is called again
         void panic();
     };
 };
\ No newline at end of file
@@ -0,0 +1,65 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+
+namespace display_controller {
+    /// @brief fixed-size lock-free single-producer/single-consumer ring.
+    /// Producer & consumer may run on different cores, neither of them ever blocks.
+    /// @tparam T trivially copyable element
+    /// @tparam Capacity number of slots, power of two
+    template <typename T, uint32_t Capacity>
+    class CommandQueue {
+        static_assert((Capacity & (Capacity - 1)) == 0, "capacity has to be a power of two");
+
+    private:
+        T slots[Capacity];
+
+        /// @brief free running counters, only producer writes head & only consumer writes tail
+        std::atomic<uint32_t> head;
+        std::atomic<uint32_t> tail;
+
+        /// @brief most slots that were ever in use, updated by producer
+        uint32_t high_water;
+        /// @brief elements rejected because the queue was full, updated by producer
+        uint32_t dropped;
+
+    public:
+        CommandQueue() : head(0), tail(0), high_water(0), dropped(0) {}
+
+        /// @brief producer side, never blocks
+        /// @return false if the queue is full and element was dropped
+        bool push(const T& element) {
+            uint32_t h = head.load(std::memory_order_relaxed);
+            uint32_t used = h - tail.load(std::memory_order_acquire);
+            if (used >= Capacity) {
+                dropped++;
+                return false;
+            }
+
+            slots[h & (Capacity - 1)] = element;
+            head.store(h + 1, std::memory_order_release);
+
+            if (used + 1 > high_water) { high_water = used + 1; }
+            return true;
+        }
+
+        /// @brief consumer side, never blocks
+        /// @return false if there was nothing to take
+        bool pop(T& element) {
+            uint32_t t = tail.load(std::memory_order_relaxed);
+            if (t == head.load(std::memory_order_acquire)) { return false; }
+
+            element = slots[t & (Capacity - 1)];
+            tail.store(t + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool is_empty() const {
+            return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+        }
+
+        uint32_t get_high_water() const { return high_water; }
+
+        uint32_t get_dropped() const { return dropped; }
+    };
+}
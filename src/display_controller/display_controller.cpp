@@ -1,19 +1,36 @@
 #include "display_controller.h"
 
+#include <string.h>
+
+#include "../logging/log.h"
+
 using namespace  display_controller;
 
-Display::Display(pico_ssd1306::SSD1306* display_driver, int msg_length) {
+Display::Display(pico_ssd1306::SSD1306* display_driver, i2c_inst_t* i2c, uint8_t address, int msg_length) :
+    panel(i2c, address),
+    battery_bar(3, 52, 124, 60)
+{
     disp = display_driver;
     current_state = DisplayState::MAIN_MENU;
     disp->setOrientation(1);
-    disp->clear();
+    frame.clear();
     last_msg_timestamp = 0;
     msg_wait_time = msg_length * 1000000;
+    battery = 0;
+    night = false;
+    panel_on = true;
+    for (uint8_t port = 0; port < DISPLAY_PORT_COUNT; port++) {
+        ports[port] = charging_protocols::PORT_STATE_DISCONNECTED;
+    }
 };
 
+size_t Display::flush() {
+    return panel.flush_async(frame);
+}
+
 bool Display::is_msg_displaying() {
     if (last_msg_timestamp >= time_us_64()) {
-        printf("tried to redraw display while message is shown\n");
+        LOG_DEBUG("tried to redraw display while message is shown\n");
         return true;
     }
     else {
@@ -22,27 +39,81 @@ bool Display::is_msg_displaying() {
 }
 
 void Display::main_menu() {
-    if (is_msg_displaying()) { return; }
+    if (is_msg_displaying() || night) { return; }
 
-    printf("drawing main menu\n");
+    LOG_DEBUG("drawing main menu\n");
 
-    disp->clear();
+    frame.clear();
 
     // battery percentage & port status divider
-    pico_ssd1306::drawRect(disp, 32, 8, 33, 38);
+    frame.draw_rect(32, 8, 33, 38);
+
+    // battery outline, the bar starts empty on the cleared frame
+    frame.draw_rect(0, 49, 127, 63);
+    battery_bar.reset();
+    battery_symbol();
 
-    // draw battery area with 0 percent
-    update_battery(-1);
+    battery_status();
+    for (uint8_t port = 0; port < DISPLAY_PORT_COUNT; port++) {
+        port_status(port);
+    }
 
-    // draw
-    disp->sendBuffer();
     current_state = DisplayState::MAIN_MENU;
 }
 
-void Display::update_battery(int percentage) {
+void Display::poll() {
+    bool msg_shown = current_state == DisplayState::DISPLAY_WARNING || current_state == DisplayState::DISPLAY_ERROR;
+    if (msg_shown && last_msg_timestamp < time_us_64()) {
+        if (night) {
+            set_panel_power(false);
+            current_state = DisplayState::NIGHT_MODE;
+            return;
+        }
+        main_menu();
+    }
+}
+
+void Display::set_panel_power(bool on) {
+    if (on == panel_on) { return; }
+
+    // driver talks over the same i2c, frame in flight has to be done first
+    panel.wait_idle();
+    if (on) { disp->turnOn(); }
+    else { disp->turnOff(); }
+    panel_on = on;
+}
+
+void Display::night_mode(bool on) {
+    if (on == night) { return; }
+    night = on;
+    LOG_INFO("display night mode %s\n", on ? "on" : "off");
+
+    // message stays until it times out, poll() finishes the switch
     if (is_msg_displaying()) { return; }
 
-    printf("updating battery percentage to %02d%\n", percentage);
+    if (on) {
+        set_panel_power(false);
+        current_state = DisplayState::NIGHT_MODE;
+    }
+    else {
+        set_panel_power(true);
+        main_menu();
+    }
+}
+
+void Display::update_battery(int percentage) {
+    if (percentage > 100) { percentage = 100; }
+    if (percentage == battery) { return; }
+    battery = percentage;
+
+    // drawn with the main menu once the message is gone
+    if (current_state != DisplayState::MAIN_MENU) { return; }
+    battery_status();
+}
+
+void Display::battery_status() {
+    int percentage = battery;
+    LOG_DEBUG("updating battery percentage to %02d%%\n", percentage);
 
     // offset if value is only 1 digit 
     int digits_offset = 0;
@@ -51,171 +122,143 @@ void Display::update_battery(int percentage) {
     }
     if (percentage >= 100) {
         digits_offset = -16;
-        percentage = 100;
     }
 
-    // clear up percentage VALUE
-    pico_ssd1306::fillRect(disp, 0, 0, 30, 48, pico_ssd1306::WriteMode::SUBTRACT);
-    // clear up percentage BAR 
-    pico_ssd1306::fillRect(disp, 1, 50, 126, 62, pico_ssd1306::WriteMode::SUBTRACT);
+    // clear up percentage VALUE, digits reach into the divider so its first column is drawn again
+    frame.fill_rect(0, 0, 32, 48, pico_ssd1306::WriteMode::SUBTRACT);
+    frame.fill_rect(32, 8, 32, 38);
 
-    // vertical percentage bar
-    pico_ssd1306::drawRect(disp, 0, 49, 127, 63);
-    pico_ssd1306::fillRect(disp, 3, 52, percentage * (124. / 100.), 60, pico_ssd1306::WriteMode::ADD);
+    // only columns between the old & new level change, % sign is taken off while they run under it
+    uint8_t level = percentage < 0 ? 0 : percentage;
+    DirtySpan columns = battery_bar.changed_columns(level);
+    bool under_symbol = !columns.is_clean() &&
+        columns.first <= DISPLAY_BATTERY_SYMBOL_X + 8 && columns.last > DISPLAY_BATTERY_SYMBOL_X;
+    if (under_symbol) { battery_symbol(); }
+    battery_bar.set(frame, level);
+    if (under_symbol) { battery_symbol(); }
 
     // format & display battery value
     char buffer[4];
     sprintf(buffer, "%d", percentage);
-    pico_ssd1306::drawText(disp, font_16x32, buffer, 0, 16 + digits_offset,
+    frame.draw_text(font_16x32, buffer, 0, 16 + digits_offset,
         pico_ssd1306::WriteMode::ADD,
         pico_ssd1306::Rotation::deg90);
+}
 
-    // draw percentage symbol
-    pico_ssd1306::drawText(disp, font_8x8, "%", 3, 53,
+void Display::battery_symbol() {
+    frame.draw_text(font_8x8, "%", DISPLAY_BATTERY_SYMBOL_X, DISPLAY_BATTERY_SYMBOL_Y,
         pico_ssd1306::WriteMode::INVERT,
         pico_ssd1306::Rotation::deg90);
-
-    disp->sendBuffer();
 }
 
-void Display::port_status(const char* port_name, int pos, ChargingModes charging_mode) {
-    if (is_msg_displaying()) { return; }
-
-    // clear up
-    pico_ssd1306::fillRect(disp, pos, 0, pos + 27, 48,
-        pico_ssd1306::WriteMode::SUBTRACT);
-
-    pico_ssd1306::drawText(disp, font_8x8, port_name, pos + 10, 8,
-        pico_ssd1306::WriteMode::ADD,
-        pico_ssd1306::Rotation::deg90);
+void display_controller::port_label(const charging_protocols::PortState& state, char* buffer) {
+    if (state.faults & charging_protocols::PORT_FAULT_PANIC) {
+        strcpy(buffer, "ERROR ");
+        return;
+    }
+    // derated port shows the voltage it's held at, e.g. "HOT 9v", or only that it's hot if the voltage isn't known
+    if ((state.faults & charging_protocols::PORT_FAULT_OVERTEMP) && state.millivolts == 0) {
+        strcpy(buffer, " HOT  ");
+        return;
+    }
+    if (state.faults & charging_protocols::PORT_FAULT_OVERTEMP) {
+        sprintf(buffer, "HOT%2uv", (unsigned)(state.millivolts + 500) / 1000 % 100);
+        return;
+    }
 
     const char* mode_text;
 
-    switch (charging_mode) {
-    case ChargingModes::Unknown: mode_text = "ERROR "; break;
+    switch (state.mode) {
+    case ChargingModes::NotConnected: mode_text = "  --  "; break;
     case ChargingModes::GEN_5v: mode_text = "GEN 5v"; break;
     case ChargingModes::QC_5v: mode_text = "QC  5v"; break;
     case ChargingModes::QC_9v: mode_text = "QC  9v"; break;
-    case ChargingModes::QC_15v: mode_text = "QC 12v"; break;
+    case ChargingModes::QC_12v: mode_text = "QC 12v"; break;
     case ChargingModes::QC_20v: mode_text = "QC 20v"; break;
     case ChargingModes::QC_Var: mode_text = "QC Var"; break;
     case ChargingModes::PD_5v: mode_text = "PD  5v"; break;
-    case ChargingModes::PD_9v: mode_text = "PD 9v"; break;
+    case ChargingModes::PD_9v: mode_text = "PD  9v"; break;
     case ChargingModes::PD_12v: mode_text = "PD 12v"; break;
     case ChargingModes::PD_20v: mode_text = "PD 20v"; break;
     case ChargingModes::PD_Var: mode_text = "PD Var"; break;
     default: mode_text = "??????"; break;
     }
 
-    printf("updating charging mode to: %s\n", mode_text);
-
-    drawText(disp, font_5x8, mode_text, pos, 9,
-        pico_ssd1306::WriteMode::ADD,
-        pico_ssd1306::Rotation::deg90);
-
-    disp->sendBuffer();
+    // continuous mode shows its voltage when it's known, e.g. "Q11.8v"
+    bool variable = state.mode == ChargingModes::QC_Var || state.mode == ChargingModes::PD_Var;
+    if (variable && state.millivolts > 0) {
+        unsigned tenths = (state.millivolts + 50) / 100;
+        sprintf(buffer, "%c%2u.%uv", mode_text[0], tenths / 10, tenths % 10);
+        return;
+    }
+    strcpy(buffer, mode_text);
 }
 
-void Display::update_port_a(int charging_mode) {
-    if (is_msg_displaying()) { return; }
+void Display::port_status(uint8_t port) {
+    static const char* names[DISPLAY_PORT_COUNT] = { "USB1", "USB2", "USBC" };
+    int pos = 105 - 32 * port;
 
-    ChargingModes c;
-    c = ChargingModes(charging_mode);
+    // clear up
+    frame.fill_rect(pos, 0, pos + 27, 48,
+        pico_ssd1306::WriteMode::SUBTRACT);
 
-    port_status("USB1", 105, c);
-}
+    frame.draw_text(font_8x8, names[port], pos + 10, 8,
+        pico_ssd1306::WriteMode::ADD,
+        pico_ssd1306::Rotation::deg90);
 
-void Display::update_port_b(int charging_mode) {
-    if (is_msg_displaying()) { return; }
+    char label[DISPLAY_PORT_LABEL_LENGTH + 1];
+    port_label(ports[port], label);
 
-    ChargingModes c;
-    c = ChargingModes(charging_mode);
+    LOG_DEBUG("updating charging mode to: %s\n", label);
 
-    port_status("USB2", 105 - 32, c);
+    frame.draw_text(font_5x8, label, pos, 9,
+        pico_ssd1306::WriteMode::ADD,
+        pico_ssd1306::Rotation::deg90);
 }
 
-void Display::update_port_c(int charging_mode) {
-    if (is_msg_displaying()) { return; }
-
-    ChargingModes c;
-    c = ChargingModes(charging_mode);
+void Display::update_port(uint8_t port, const charging_protocols::PortState& state) {
+    if (port >= DISPLAY_PORT_COUNT) {
+        LOG_WARN("display update for unknown port %d\n", port);
+        return;
+    }
+    if (ports[port] == state) { return; }
+    ports[port] = state;
 
-    port_status("USBC", 105 - 64, c);
+    // drawn with the main menu once the message is gone
+    if (current_state != DisplayState::MAIN_MENU) { return; }
+    port_status(port);
 }
 
 void Display::display_msg(const char* heading, const char* msg, const char* details) {
-    printf("displaying a message: %s\n", msg);
+    LOG_INFO("displaying a message: %s\n", msg);
+    set_panel_power(true);
 
-    disp->clear();
+    frame.clear();
 
-    pico_ssd1306::drawText(disp, font_12x16, heading, 108, 0,
+    frame.draw_text(font_12x16, heading, 108, 0,
         pico_ssd1306::WriteMode::ADD,
         pico_ssd1306::Rotation::deg90);
 
 
     // draw message
-    pico_ssd1306::drawText(disp, font_5x8, msg, 108 - 16, 0,
+    frame.draw_text(font_5x8, msg, 108 - 16, 0,
         pico_ssd1306::WriteMode::ADD,
         pico_ssd1306::Rotation::deg90);
 
 
-    std::vector<std::string> details_lines = cstr_to_lines(details, 12);
-
+    LineSpan details_lines[DISPLAY_MSG_MAX_LINES];
+    uint8_t line_count = wrap_lines(details, DISPLAY_MSG_LINE_WIDTH, details_lines, DISPLAY_MSG_MAX_LINES);
 
     // draw details
-    int idx = 0;
-
-    while (idx < details_lines.size() - 1) {
-        pico_ssd1306::drawText(disp, font_5x8, details_lines[idx].c_str(), 108 - 32 - (9 * idx), 0,
+    for (uint8_t idx = 0; idx < line_count; idx++) {
+        frame.draw_text(font_5x8, details_lines[idx].text, details_lines[idx].length, 108 - 32 - (9 * idx), 0,
             pico_ssd1306::WriteMode::ADD,
             pico_ssd1306::Rotation::deg90);
-
-        idx++;
     }
-    disp->sendBuffer();
 
     last_msg_timestamp = time_us_64() + msg_wait_time;
 }
 
-
-std::vector<std::string> Display::cstr_to_lines(const char* cstr, int line_width) {
-    // i don't understand anything now
-    std::vector<std::string> words{};
-    std::string str = cstr;
-
-    // remove all spaces from a string and build string array of words
-    size_t pos = 0;
-    while ((pos = str.find(" ")) != std::string::npos) {
-        words.push_back(str.substr(0, pos));
-        str.erase(0, pos + 1);
-    }
-
-    std::vector<std::string> result{};
-
-    size_t ptr = 0;
-    std::string buf;
-    while (ptr < words.size()) {
-        // build element in array if it's len is <= line_width
-        size_t temp_ptr = ptr;
-        while (buf.length() + words[ptr].length() <= line_width && ptr < words.size()) {
-            // add spaces between words
-            if (buf.length() != 0) {
-                buf.append(" ");
-            }
-            buf.append(words[ptr]);
-            ptr++;
-        }
-        if (temp_ptr == ptr && ptr != words.size()) {
-            buf = words[ptr];
-            ptr++;
-        }
-
-        result.push_back(buf);
-        buf.clear();
-    }
-    return result;
-}
-
 void Display::warning(const char* msg, const char* details) {
     current_state = DisplayState::DISPLAY_WARNING;
     display_msg("WARN", msg, details);
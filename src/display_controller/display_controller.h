@@ -1,13 +1,30 @@
 #pragma once
 #include <stdio.h>
-#include <string>
-#include <vector>
+
+#include "hardware/i2c.h"
 
 #include "../../pico-ssd1306/ssd1306.h"
-#include "../../pico-ssd1306/shapeRenderer/ShapeRenderer.h"
 #include "../../pico-ssd1306/textRenderer/TextRenderer.h"
 #include "../../pico-ssd1306/textRenderer/16x32_font.h"
 
+#include "framebuffer.h"
+#include "progress_bar.h"
+#include "panel.h"
+#include "text_layout.h"
+#include "../charging_protocols/port_state.h"
+
+// details of a message are wrapped to this many characters per line
+#define DISPLAY_MSG_LINE_WIDTH 12
+// lines of details that fit below heading & message
+#define DISPLAY_MSG_MAX_LINES 9
+// USB1, USB2 & USBC
+#define DISPLAY_PORT_COUNT 3
+// characters of a port mode label
+#define DISPLAY_PORT_LABEL_LENGTH 6
+// % sign is drawn inverted over the left end of the battery bar, it covers columns X + 1 .. X + 8
+#define DISPLAY_BATTERY_SYMBOL_X 3
+#define DISPLAY_BATTERY_SYMBOL_Y 53
+
 namespace display_controller {
     /// @brief possible states of the display
     enum class DisplayState {
@@ -16,27 +33,21 @@ namespace display_controller {
         DISPLAY_WARNING,
         DISPLAY_ERROR,
     };
-    /// @brief possible modes of all ports
-    enum class ChargingModes {
-        GEN_5v,
-        QC_5v,
-        QC_9v,
-        QC_15v,
-        QC_20v,
-        QC_Var,
-        PD_5v,
-        PD_9v,
-        PD_12v,
-        PD_20v,
-        PD_Var,
-        Unknown
-    };
+    /// @brief text shown for a port, e.g. "QC  9v" or "Q11.8v" for continuous mode
+    /// @param buffer at least DISPLAY_PORT_LABEL_LENGTH + 1 characters
+    void port_label(const charging_protocols::PortState& state, char* buffer);
 
     class Display {
     private:
-        /// @brief display driver, used to draw text & shapes
+        /// @brief display driver, used for panel init & configuration
         pico_ssd1306::SSD1306* disp;
 
+        /// @brief everything is drawn here, only touched regions are sent on flush()
+        FrameBuffer frame;
+
+        /// @brief i2c link used to flush the frame
+        Panel panel;
+
         /// @brief state of a display at the moment
         DisplayState current_state;
 
@@ -46,11 +57,33 @@ namespace display_controller {
         /// @brief message wait time in microseconds
         uint64_t msg_wait_time;
 
-        /// @brief USB port status update/redraw, height of an element is 24 pixels
-        /// @param port_name short port name (6 char max)
-        /// @param pos vertical position of UI element
-        /// @param charging_mode integer value of PD_Charging  
-        void port_status(const char* port_name, int pos, ChargingModes charging_mode);
+        /// @brief last state of every port, widgets are only redrawn when it changes
+        charging_protocols::PortState ports[DISPLAY_PORT_COUNT];
+
+        /// @brief last battery percentage
+        int battery;
+
+        /// @brief fill of the battery outline, follows battery
+        ProgressBar battery_bar;
+
+        /// @brief night mode was requested, messages still light the panel up until they time out
+        bool night;
+
+        /// @brief panel is not switched off
+        bool panel_on;
+
+        /// @brief switch panel on or off, waits for the frame in flight first
+        void set_panel_power(bool on);
+
+        /// @brief USB port status redraw from its last state, height of an element is 24 pixels
+        /// @param port 0 - USB1, 1 - USB2, 2 - USBC
+        void port_status(uint8_t port);
+
+        /// @brief battery value & bar redraw from the last percentage
+        void battery_status();
+
+        /// @brief toggle % sign over the battery bar, drawing it twice removes it
+        void battery_symbol();
 
         /// checks timer to answer if message should be displaying now
         bool is_msg_displaying();
@@ -61,40 +94,53 @@ namespace display_controller {
         /// @param details details of message
         void display_msg(const char* heading, const char* msg, const char* details);
 
-        /// @brief Chopping const char* into string array with max length of each entry <= line_width, word endings are preserved.
-        /// Exception: If single word is longer than line_width then it's not chopped. 
-        /// Used to map words to fixed width screen.
-        /// @param cstr const char* to map
-        /// @param line_width max length of one entry in array
-        /// @return array of strings, each string length will not exceed line_width 
-        std::vector<std::string> cstr_to_lines(const char* cstr, int line_width);
 
 
     public:
 
         /// @brief Display constructor
-        /// @param display_driver initialized display driver that's used to draw text & shapes 
+        /// @param display_driver initialized display driver
+        /// @param i2c i2c controller the display is connected to
+        /// @param address i2c address of the display
         /// @param msg_length time to wait when showing message in seconds
-        Display(pico_ssd1306::SSD1306* display_driver, int msg_length);
+        Display(pico_ssd1306::SSD1306* display_driver, i2c_inst_t* i2c, uint8_t address, int msg_length);
+
+        /// @brief start sending everything drawn since the last frame to the panel, never blocks.
+        /// If the previous frame is still in flight or the frame cap didn't pass, changes wait for the next call.
+        /// @return number of bytes queued for i2c
+        size_t flush();
+
+        /// @brief is the last frame still being transferred over i2c
+        bool is_frame_in_flight() { return panel.is_busy(); }
+
+        /// @brief limit how often frames are sent
+        /// @param fps max frames per second, 0 to disable the cap
+        void set_frame_rate(uint8_t fps) { panel.set_frame_rate(fps); }
+
+        /// @brief bytes sent by the last flush, includes control bytes
+        size_t get_bytes_last_frame() const { return panel.get_bytes_last_frame(); }
 
-        /// @brief clear up and initialize main menu
+        /// @brief clear up and draw main menu with last known battery & port states
         void main_menu();
 
-        /// @brief set battery percentage on a display
-        /// @param percentage current battery charge mapped from 0 to 100
-        void update_battery(int percentage);
+        /// @brief bring main menu (or night mode) back once a message timed out, call it regularly
+        void poll();
+
+        /// @brief switch panel off & stop drawing, or switch it on & draw main menu.
+        /// Port & battery updates are kept while it's off and drawn on wake up
+        /// @param on true to enter night mode
+        void night_mode(bool on);
 
-        /// @brief redraw charging mode of 1st (higher) USB-A Port on the display
-        /// @param charging_mode PD_Mode or QC_Mode enum!
-        void update_port_a(int charging_mode);
+        bool is_night() const { return night; }
 
-        /// @brief redraw charging mode of 2nd (lower) USB-A Port on the display
-        /// @param charging_mode PD_Mode or QC_Mode enum!
-        void update_port_b(int charging_mode);
+        /// @brief set battery percentage on a display, redrawn only if it changed
+        /// @param percentage current battery charge mapped from 0 to 100
+        void update_battery(int percentage);
 
-        /// @brief redraw charging mode of Type-C Port on the display
-        /// @param charging_mode PD_Mode or QC_Mode enum!
-        void update_port_c(int charging_mode);
+        /// @brief set state of a port, its widget is redrawn only if the state changed.
+        /// While a message is shown the state is kept and drawn with the main menu
+        /// @param port 0 - USB1 (higher USB-A), 1 - USB2 (lower USB-A), 2 - USBC
+        void update_port(uint8_t port, const charging_protocols::PortState& state);
 
         /// @brief display a warning on the screen
         /// @param msg warning 
@@ -0,0 +1,101 @@
+#include "display_service.h"
+
+#include "../logging/log.h"
+#include "../profiler/profiler.h"
+
+using namespace display_controller;
+
+DisplayService::DisplayService(i2c_inst_t* i2c, uint8_t address, int msg_length, uint8_t fps) :
+    heartbeat(0)
+{
+    this->i2c = i2c;
+    this->address = address;
+    this->msg_length = msg_length;
+    this->fps = fps;
+}
+
+void DisplayService::start() {
+    multicore_launch_core1(core1_entry);
+    // core 1 takes its service from the inter-core FIFO
+    multicore_fifo_push_blocking((uintptr_t)this);
+    // flash writes park core 1 from now on, it takes a few microseconds until it can be parked
+    while (!multicore_lockout_victim_is_initialized(1)) { tight_loop_contents(); }
+}
+
+void DisplayService::core1_entry() {
+    DisplayService* service = (DisplayService*)(uintptr_t)multicore_fifo_pop_blocking();
+    service->run();
+}
+
+void DisplayService::run() {
+    // SysTick is per core
+    profiler::init_core();
+    // core 0 parks this core while it writes flash
+    multicore_lockout_victim_init();
+
+    pico_ssd1306::SSD1306* driver = new (driver_storage) pico_ssd1306::SSD1306(i2c, address, pico_ssd1306::Size::W128xH64);
+    Display* display = new (display_storage) Display(driver, i2c, address, msg_length);
+    display->set_frame_rate(fps);
+
+    while (true) {
+        DisplayCommand command;
+        bool idle = true;
+        while (queue.pop(command)) {
+            PROFILE_SCOPE(profiler::Stage::DISPLAY);
+            execute(*display, command);
+            idle = false;
+        }
+
+        display->poll();
+
+        // frame stays dirty while capped or in flight, so keep trying
+        {
+            PROFILE_SCOPE(profiler::Stage::FLUSH);
+            display->flush();
+        }
+        heartbeat.store(heartbeat.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+        if (idle) {
+            sleep_us(display->is_night() ? DISPLAY_NIGHT_SLEEP_US : DISPLAY_IDLE_SLEEP_US);
+        }
+    }
+}
+
+void DisplayService::execute(Display& display, const DisplayCommand& command) {
+    switch (command.type) {
+    case DisplayCommandType::MAIN_MENU: display.main_menu(); break;
+    case DisplayCommandType::BATTERY: display.update_battery(command.value); break;
+    case DisplayCommandType::WARNING: display.warning(command.msg, command.details); break;
+    case DisplayCommandType::ERROR: display.error(command.msg, command.details); break;
+    case DisplayCommandType::PORT_STATE: display.update_port(command.port, command.port_state); break;
+    case DisplayCommandType::NIGHT_MODE: display.night_mode(command.value != 0); break;
+    }
+}
+
+bool DisplayService::post(const DisplayCommand& command) {
+    return queue.push(command);
+}
+
+bool DisplayService::post_main_menu() {
+    return post({ DisplayCommandType::MAIN_MENU, 0, 0, nullptr, nullptr });
+}
+
+bool DisplayService::post_port_state(uint8_t port, const charging_protocols::PortState& state) {
+    return post({ DisplayCommandType::PORT_STATE, port, 0, nullptr, nullptr, state });
+}
+
+bool DisplayService::post_battery(int percentage) {
+    return post({ DisplayCommandType::BATTERY, 0, (int16_t)percentage, nullptr, nullptr });
+}
+
+bool DisplayService::post_warning(const char* msg, const char* details) {
+    return post({ DisplayCommandType::WARNING, 0, 0, msg, details });
+}
+
+bool DisplayService::post_error(const char* msg, const char* details) {
+    return post({ DisplayCommandType::ERROR, 0, 0, msg, details });
+}
+
+bool DisplayService::post_night_mode(bool on) {
+    return post({ DisplayCommandType::NIGHT_MODE, 0, on, nullptr, nullptr });
+}
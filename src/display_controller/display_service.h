@@ -0,0 +1,107 @@
+#pragma once
+#include <stdio.h>
+#include <new>
+#include <atomic>
+
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+#include "hardware/i2c.h"
+
+#include "display_controller.h"
+#include "command_queue.h"
+
+#define DISPLAY_QUEUE_LENGTH 32
+// how long core 1 sleeps when there is nothing to draw
+#define DISPLAY_IDLE_SLEEP_US 1000
+// same while panel is off, bounds how late a message shows up at night
+#define DISPLAY_NIGHT_SLEEP_US (20 * 1000)
+
+namespace display_controller {
+    enum class DisplayCommandType : uint8_t {
+        MAIN_MENU,
+        PORT_STATE,
+        BATTERY,
+        WARNING,
+        ERROR,
+        NIGHT_MODE,
+    };
+
+    /// @brief compact render request posted by core 0.
+    /// Strings are not copied, they have to live forever (string literals).
+    struct DisplayCommand {
+        DisplayCommandType type;
+        /// @brief port index for PORT_STATE: 0 - USB1, 1 - USB2, 2 - USBC
+        uint8_t port;
+        /// @brief battery percentage, 1/0 for NIGHT_MODE on/off
+        int16_t value;
+        const char* msg;
+        const char* details;
+        charging_protocols::PortState port_state;
+    };
+
+    /// @brief runs Display on core 1, core 0 only posts commands and never waits for the display
+    class DisplayService {
+    private:
+        CommandQueue<DisplayCommand, DISPLAY_QUEUE_LENGTH> queue;
+
+        i2c_inst_t* i2c;
+        uint8_t address;
+        int msg_length;
+        uint8_t fps;
+
+        /// @brief storage for objects constructed on core 1
+        alignas(pico_ssd1306::SSD1306) uint8_t driver_storage[sizeof(pico_ssd1306::SSD1306)];
+        alignas(Display) uint8_t display_storage[sizeof(Display)];
+
+        /// @brief incremented by core 1 on every pass of its loop
+        std::atomic<uint32_t> heartbeat;
+
+        /// @brief push command, counts it as dropped if queue is full
+        bool post(const DisplayCommand& command);
+
+        /// @brief apply command to the display
+        void execute(Display& display, const DisplayCommand& command);
+
+        /// @brief body of core 1, never returns
+        void run();
+
+        static void core1_entry();
+
+    public:
+        /// @param i2c initialized i2c controller the display is connected to
+        /// @param address i2c address of the display
+        /// @param msg_length time to wait when showing message in seconds
+        /// @param fps frame cap of the display
+        DisplayService(i2c_inst_t* i2c, uint8_t address, int msg_length, uint8_t fps);
+
+        /// @brief launch core 1, display is initialized there. Returns once core 1 can be parked with
+        /// multicore_lockout_start_blocking(), before the panel is up
+        void start();
+
+        /// @brief clear up and draw main menu
+        bool post_main_menu();
+
+        /// @brief new state of a port, its widget is redrawn if it differs from what's shown
+        /// @param port 0 - USB1, 1 - USB2, 2 - USBC
+        /// @param state snapshot published by the port
+        bool post_port_state(uint8_t port, const charging_protocols::PortState& state);
+
+        /// @brief set battery percentage
+        bool post_battery(int percentage);
+
+        /// @brief show a warning, strings have to live forever
+        bool post_warning(const char* msg, const char* details);
+
+        /// @brief show an error, strings have to live forever
+        bool post_error(const char* msg, const char* details);
+
+        /// @brief switch panel off, or on with main menu
+        bool post_night_mode(bool on);
+
+        uint32_t get_high_water() const { return queue.get_high_water(); }
+
+        uint32_t get_dropped() const { return queue.get_dropped(); }
+
+        uint32_t get_heartbeat() const { return heartbeat.load(std::memory_order_relaxed); }
+    };
+}
@@ -0,0 +1,215 @@
+#include "framebuffer.h"
+
+using namespace display_controller;
+
+static_assert(DISPLAY_WIDTH % 4 == 0, "pages have to start on a word boundary");
+
+// buffer is accessed as bytes & words
+typedef uint32_t __attribute__((may_alias)) FrameWord;
+
+template <typename T>
+static inline void combine(T& value, T bits, pico_ssd1306::WriteMode mode) {
+    switch (mode) {
+    case pico_ssd1306::WriteMode::ADD: value |= bits; break;
+    case pico_ssd1306::WriteMode::SUBTRACT: value &= ~bits; break;
+    case pico_ssd1306::WriteMode::INVERT: value ^= bits; break;
+    }
+}
+
+FrameBuffer::FrameBuffer() {
+    clear();
+}
+
+void FrameBuffer::clear() {
+    memset(buffer, 0, sizeof(buffer));
+    mark_all_dirty();
+}
+
+void FrameBuffer::plot(uint8_t x, uint8_t y, pico_ssd1306::WriteMode mode) {
+    combine<uint8_t>(buffer[x + (y / 8) * DISPLAY_WIDTH], 1 << (y & 7), mode);
+}
+
+void FrameBuffer::fill_span(uint8_t page, uint8_t x_start, uint8_t x_end, uint8_t mask, pico_ssd1306::WriteMode mode) {
+    uint8_t* row = &buffer[page * DISPLAY_WIDTH];
+    int16_t x = x_start;
+
+    // single columns up to a word boundary, then 4 at a time, then the rest
+    for (; x <= x_end && (x & 3) != 0; x++) {
+        combine<uint8_t>(row[x], mask, mode);
+    }
+    uint32_t mask_word = mask * 0x01010101u;
+    for (; x + 3 <= x_end; x += 4) {
+        combine<uint32_t>(*(FrameWord*)&row[x], mask_word, mode);
+    }
+    for (; x <= x_end; x++) {
+        combine<uint8_t>(row[x], mask, mode);
+    }
+}
+
+void FrameBuffer::set_pixel(int16_t x, int16_t y, pico_ssd1306::WriteMode mode) {
+    if (x < 0 || x >= DISPLAY_WIDTH || y < 0 || y >= DISPLAY_HEIGHT) { return; }
+
+    plot(x, y, mode);
+    mark_dirty(x, y, x, y);
+}
+
+void FrameBuffer::draw_rect(int16_t x_start, int16_t y_start, int16_t x_end, int16_t y_end,
+    pico_ssd1306::WriteMode mode) {
+    fill_rect(x_start, y_start, x_end, y_start, mode);
+    fill_rect(x_start, y_end, x_end, y_end, mode);
+    // vertical edges skip the corners, so INVERT doesn't flip them twice
+    fill_rect(x_start, y_start + 1, x_start, y_end - 1, mode);
+    fill_rect(x_end, y_start + 1, x_end, y_end - 1, mode);
+}
+
+void FrameBuffer::fill_rect(int16_t x_start, int16_t y_start, int16_t x_end, int16_t y_end,
+    pico_ssd1306::WriteMode mode) {
+    // clip to the screen
+    if (x_start < 0) { x_start = 0; }
+    if (y_start < 0) { y_start = 0; }
+    if (x_end >= DISPLAY_WIDTH) { x_end = DISPLAY_WIDTH - 1; }
+    if (y_end >= DISPLAY_HEIGHT) { y_end = DISPLAY_HEIGHT - 1; }
+    if (x_start > x_end || y_start > y_end) { return; }
+
+    uint8_t first_page = y_start / 8;
+    uint8_t last_page = y_end / 8;
+    for (uint8_t page = first_page; page <= last_page; page++) {
+        // first & last page may only be covered partly
+        uint8_t mask = 0xFF;
+        if (page == first_page) { mask &= 0xFF << (y_start & 7); }
+        if (page == last_page) { mask &= 0xFF >> (7 - (y_end & 7)); }
+        fill_span(page, x_start, x_end, mask, mode);
+    }
+    mark_dirty(x_start, y_start, x_end, y_end);
+}
+
+void FrameBuffer::draw_char(const unsigned char* font, char c, int16_t anchor_x, int16_t anchor_y,
+    pico_ssd1306::WriteMode mode, pico_ssd1306::Rotation rotation) {
+    if (c < 32) { return; }
+
+    uint8_t font_width = font[0];
+    uint8_t font_height = font[1];
+
+    // glyphs are stored column by column, font_height bits per column
+    uint16_t seek = (c - 32) * (font_width * font_height) / 8 + 2;
+    uint8_t b_seek = 0;
+
+    for (uint8_t x = 0; x < font_width; x++) {
+        for (uint8_t y = 0; y < font_height; y++) {
+            if (font[seek] >> b_seek & 0b00000001) {
+                int16_t px, py;
+                if (rotation == pico_ssd1306::Rotation::deg90) {
+                    px = anchor_x + font_height - y;
+                    py = anchor_y + x;
+                }
+                else {
+                    px = anchor_x + x;
+                    py = anchor_y + y;
+                }
+                if (px >= 0 && px < DISPLAY_WIDTH && py >= 0 && py < DISPLAY_HEIGHT) {
+                    plot(px, py, mode);
+                }
+            }
+            b_seek++;
+            if (b_seek == 8) {
+                b_seek = 0;
+                seek++;
+            }
+        }
+    }
+}
+
+void FrameBuffer::draw_rotated_char(const RotatedFont& font, char c, int16_t anchor_x, int16_t anchor_y,
+    pico_ssd1306::WriteMode mode) {
+    if (c < GLYPH_ATLAS_FIRST_CHAR || c >= GLYPH_ATLAS_FIRST_CHAR + GLYPH_ATLAS_CHARS) { return; }
+    // rows above the screen are shifted out, a glyph is at most 16 rows
+    if (anchor_y <= -16 || anchor_y >= DISPLAY_HEIGHT) { return; }
+
+    const uint8_t* glyph = font.glyph(c);
+    uint8_t shift = anchor_y & 7;
+    int8_t first_page = anchor_y >> 3;
+
+    for (uint8_t col = 0; col < font.height; col++, glyph += font.column_bytes) {
+        int16_t x = anchor_x + 1 + col;
+        if (x < 0 || x >= DISPLAY_WIDTH) { continue; }
+
+        uint32_t strip = glyph[0];
+        if (font.column_bytes > 1) { strip |= glyph[1] << 8; }
+        if (strip == 0) { continue; }
+        strip <<= shift;
+
+        // strip covers up to 3 pages once it's shifted
+        for (int8_t page = first_page; strip != 0; page++, strip >>= 8) {
+            if (page < 0) { continue; }
+            if (page >= DISPLAY_PAGES) { break; }
+
+            combine<uint8_t>(buffer[page * DISPLAY_WIDTH + x], strip & 0xFF, mode);
+        }
+    }
+}
+
+void FrameBuffer::draw_text(const unsigned char* font, const char* text, int16_t anchor_x, int16_t anchor_y,
+    pico_ssd1306::WriteMode mode, pico_ssd1306::Rotation rotation) {
+    draw_text(font, text, strlen(text), anchor_x, anchor_y, mode, rotation);
+}
+
+void FrameBuffer::draw_text(const unsigned char* font, const char* text, size_t length, int16_t anchor_x, int16_t anchor_y,
+    pico_ssd1306::WriteMode mode, pico_ssd1306::Rotation rotation) {
+    uint8_t font_width = font[0];
+    uint8_t font_height = font[1];
+
+    // every glyph of the UI is drawn turned, atlas makes it a few byte operations per column
+    const RotatedFont* rotated = rotation == pico_ssd1306::Rotation::deg90 ? find_rotated_font(font) : nullptr;
+
+    int16_t n = 0;
+    while ((size_t)n < length) {
+        if (rotated != nullptr) {
+            draw_rotated_char(*rotated, text[n], anchor_x, anchor_y + n * font_width, mode);
+        }
+        else if (rotation == pico_ssd1306::Rotation::deg90) {
+            draw_char(font, text[n], anchor_x, anchor_y + n * font_width, mode, rotation);
+        }
+        else {
+            draw_char(font, text[n], anchor_x + n * font_width, anchor_y, mode, rotation);
+        }
+        n++;
+    }
+    if (n == 0) { return; }
+
+    if (rotation == pico_ssd1306::Rotation::deg90) {
+        mark_dirty(anchor_x + 1, anchor_y, anchor_x + font_height, anchor_y + n * font_width - 1);
+    }
+    else {
+        mark_dirty(anchor_x, anchor_y, anchor_x + n * font_width - 1, anchor_y + font_height - 1);
+    }
+}
+
+void FrameBuffer::mark_dirty(int16_t x_start, int16_t y_start, int16_t x_end, int16_t y_end) {
+    if (x_start < 0) { x_start = 0; }
+    if (y_start < 0) { y_start = 0; }
+    if (x_end >= DISPLAY_WIDTH) { x_end = DISPLAY_WIDTH - 1; }
+    if (y_end >= DISPLAY_HEIGHT) { y_end = DISPLAY_HEIGHT - 1; }
+    if (x_start > x_end || y_start > y_end) { return; }
+
+    for (uint8_t page = y_start / 8; page <= y_end / 8; page++) {
+        DirtySpan& span = dirty[page];
+        if (span.is_clean()) {
+            span = { (uint8_t)x_start, (uint8_t)x_end };
+            continue;
+        }
+        if (x_start < span.first) { span.first = x_start; }
+        if (x_end > span.last) { span.last = x_end; }
+    }
+}
+
+void FrameBuffer::mark_all_dirty() {
+    for (DirtySpan& span : dirty) {
+        span = { 0, DISPLAY_WIDTH - 1 };
+    }
+}
+
+void FrameBuffer::clear_dirty() {
+    for (DirtySpan& span : dirty) {
+        span = { 0xFF, 0 };
+    }
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+
+#include "../../pico-ssd1306/ssd1306.h"
+#include "../../pico-ssd1306/textRenderer/TextRenderer.h"
+
+#include "glyph_atlas.h"
+
+#define DISPLAY_WIDTH 128
+#define DISPLAY_PAGES 8
+#define DISPLAY_HEIGHT (DISPLAY_PAGES * 8)
+
+namespace display_controller {
+    /// @brief range of columns inside one page that was touched since the last flush
+    struct DirtySpan {
+        uint8_t first;
+        uint8_t last;
+
+        bool is_clean() const { return first > last; }
+    };
+
+    /// @brief local copy of SSD1306 GDDRAM (page-major, LSB is the top pixel of a page)
+    /// that remembers which columns of every page were drawn to since the last flush
+    class FrameBuffer {
+    private:
+        /// @brief word aligned, so runs of a page can be written 4 columns at a time
+        alignas(4) uint8_t buffer[DISPLAY_PAGES * DISPLAY_WIDTH];
+        DirtySpan dirty[DISPLAY_PAGES];
+
+        /// @brief write single pixel without touching dirty spans, coordinates have to be valid
+        void plot(uint8_t x, uint8_t y, pico_ssd1306::WriteMode mode);
+
+        /// @brief combine mask with columns x_start..x_end of a page, without touching dirty spans
+        /// @param mask rows of the page, LSB is the top one
+        void fill_span(uint8_t page, uint8_t x_start, uint8_t x_end, uint8_t mask, pico_ssd1306::WriteMode mode);
+
+        void draw_char(const unsigned char* font, char c, int16_t anchor_x, int16_t anchor_y,
+            pico_ssd1306::WriteMode mode, pico_ssd1306::Rotation rotation);
+
+        /// @brief deg90 glyph from a pre-rotated atlas, whole bytes are combined with the page bytes
+        void draw_rotated_char(const RotatedFont& font, char c, int16_t anchor_x, int16_t anchor_y,
+            pico_ssd1306::WriteMode mode);
+
+    public:
+        FrameBuffer();
+
+        /// @brief zero whole buffer and mark it dirty
+        void clear();
+
+        /// @brief set pixel, out of bounds coordinates are ignored
+        void set_pixel(int16_t x, int16_t y, pico_ssd1306::WriteMode mode = pico_ssd1306::WriteMode::ADD);
+
+        /// @brief rectangle outline, corners are inclusive
+        void draw_rect(int16_t x_start, int16_t y_start, int16_t x_end, int16_t y_end,
+            pico_ssd1306::WriteMode mode = pico_ssd1306::WriteMode::ADD);
+
+        /// @brief filled rectangle, corners are inclusive. Works on whole page bytes, a full-height page
+        /// costs one write per 4 columns
+        void fill_rect(int16_t x_start, int16_t y_start, int16_t x_end, int16_t y_end,
+            pico_ssd1306::WriteMode mode = pico_ssd1306::WriteMode::ADD);
+
+        /// @brief render text with one of pico-ssd1306 fonts, same placement rules as pico_ssd1306::drawText
+        void draw_text(const unsigned char* font, const char* text, int16_t anchor_x, int16_t anchor_y,
+            pico_ssd1306::WriteMode mode = pico_ssd1306::WriteMode::ADD,
+            pico_ssd1306::Rotation rotation = pico_ssd1306::Rotation::deg0);
+
+        /// @brief render first `length` characters of text, text doesn't need to be null terminated
+        void draw_text(const unsigned char* font, const char* text, size_t length, int16_t anchor_x, int16_t anchor_y,
+            pico_ssd1306::WriteMode mode = pico_ssd1306::WriteMode::ADD,
+            pico_ssd1306::Rotation rotation = pico_ssd1306::Rotation::deg0);
+
+        /// @brief mark area as touched, it is clipped to the screen
+        void mark_dirty(int16_t x_start, int16_t y_start, int16_t x_end, int16_t y_end);
+
+        /// @brief mark whole screen as touched
+        void mark_all_dirty();
+
+        /// @brief forget all touched areas, called after a flush
+        void clear_dirty();
+
+        const DirtySpan& dirty_span(uint8_t page) const { return dirty[page]; }
+
+        const uint8_t* page_data(uint8_t page) const { return &buffer[page * DISPLAY_WIDTH]; }
+    };
+}
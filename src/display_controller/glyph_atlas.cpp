@@ -0,0 +1,11 @@
+#include "glyph_atlas.h"
+
+using namespace display_controller;
+
+const RotatedFont* display_controller::find_rotated_font(const unsigned char* font) {
+    for (uint8_t i = 0; i < rotated_font_count; i++) {
+        const RotatedFont& rotated = rotated_fonts[i];
+        if (rotated.width == font[0] && rotated.height == font[1]) { return &rotated; }
+    }
+    return nullptr;
+}
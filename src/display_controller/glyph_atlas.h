@@ -0,0 +1,61 @@
+#pragma once
+#include <stdint.h>
+
+// pico-ssd1306 fonts hold printable ASCII only
+#define GLYPH_ATLAS_FIRST_CHAR 32
+#define GLYPH_ATLAS_CHARS 95
+
+namespace display_controller {
+    /// @brief pico-ssd1306 font turned by 90 degrees, every glyph is `height` screen columns
+    /// and every column is `column_bytes` SSD1306 page-major bytes (LSB is the top pixel)
+    struct RotatedFont {
+        uint8_t width;
+        uint8_t height;
+        uint8_t column_bytes;
+        const uint8_t* glyphs;
+
+        const uint8_t* glyph(char c) const {
+            return glyphs + (c - GLYPH_ATLAS_FIRST_CHAR) * height * column_bytes;
+        }
+    };
+
+    /// @brief storage of a rotated font while it's built
+    /// @tparam W glyph width of the source font, it becomes height on screen
+    /// @tparam H glyph height of the source font, it becomes width on screen
+    template <uint8_t W, uint8_t H>
+    struct GlyphAtlas {
+        static constexpr uint8_t COLUMN_BYTES = (W + 7) / 8;
+        uint8_t bytes[GLYPH_ATLAS_CHARS * H * COLUMN_BYTES];
+    };
+
+    /// @brief rotate a pico-ssd1306 font, same placement as Rotation::deg90:
+    /// glyph pixel (x, y) lands in screen column height - 1 - y, row x
+    template <uint8_t W, uint8_t H>
+    GlyphAtlas<W, H> build_atlas(const unsigned char* font) {
+        GlyphAtlas<W, H> atlas = {};
+        constexpr uint8_t column_bytes = GlyphAtlas<W, H>::COLUMN_BYTES;
+
+        for (uint16_t g = 0; g < GLYPH_ATLAS_CHARS; g++) {
+            // source glyphs are stored column by column, H bits per column
+            uint32_t seek = g * (W * H) / 8 + 2;
+            for (uint16_t x = 0; x < W; x++) {
+                for (uint16_t y = 0; y < H; y++) {
+                    uint16_t bit = x * H + y;
+                    if (!(font[seek + bit / 8] >> (bit % 8) & 1)) { continue; }
+
+                    uint32_t column = g * H + (H - 1 - y);
+                    atlas.bytes[column * column_bytes + x / 8] |= 1 << (x % 8);
+                }
+            }
+        }
+        return atlas;
+    }
+
+    /// @brief atlases of all pico-ssd1306 fonts, generated at build time by tools/glyph_atlas
+    extern const RotatedFont rotated_fonts[];
+    extern const uint8_t rotated_font_count;
+
+    /// @brief rotated copy of a pico-ssd1306 font, fonts are told apart by glyph size
+    /// @return nullptr if there's no atlas for the font
+    const RotatedFont* find_rotated_font(const unsigned char* font);
+}
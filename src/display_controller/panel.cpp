@@ -0,0 +1,132 @@
+#include "panel.h"
+
+using namespace display_controller;
+
+Panel::Panel(i2c_inst_t* i2c, uint8_t address) {
+    this->i2c = i2c;
+    this->address = address;
+    memset(shown, 0, sizeof(shown));
+    shown_valid = false;
+    bytes_last_frame = 0;
+    aborted_frames = 0;
+    frame_interval_us = 0;
+    last_frame_start = 0;
+
+    dma_channel = dma_claim_unused_channel(true);
+    dma_channel_config config = dma_channel_get_default_config(dma_channel);
+    channel_config_set_transfer_data_size(&config, DMA_SIZE_16);
+    channel_config_set_read_increment(&config, true);
+    channel_config_set_write_increment(&config, false);
+    // paced by TX FIFO level
+    channel_config_set_dreq(&config, i2c_hw_index(i2c) == 0 ? DREQ_I2C0_TX : DREQ_I2C1_TX);
+    dma_channel_configure(dma_channel, &config, &i2c_get_hw(i2c)->data_cmd, stream, 0, false);
+}
+
+void Panel::invalidate() {
+    shown_valid = false;
+}
+
+void Panel::set_frame_rate(uint8_t fps) {
+    frame_interval_us = fps == 0 ? 0 : 1000000 / fps;
+}
+
+size_t Panel::serialize_region(uint16_t* out, uint8_t page, uint8_t first, uint8_t last, const uint8_t* data) {
+    const uint8_t header[PANEL_REGION_HEADER_BYTES] = {
+        // Co bit set: every command byte is preceded by its own control byte
+        SSD1306_CONTROL_CMD_CONTINUE, SSD1306_CMD_COLUMN_ADDR,
+        SSD1306_CONTROL_CMD_CONTINUE, first,
+        SSD1306_CONTROL_CMD_CONTINUE, last,
+        SSD1306_CONTROL_CMD_CONTINUE, SSD1306_CMD_PAGE_ADDR,
+        SSD1306_CONTROL_CMD_CONTINUE, page,
+        SSD1306_CONTROL_CMD_CONTINUE, page,
+        // rest of transaction is GDDRAM data
+        SSD1306_CONTROL_DATA
+    };
+
+    size_t n = 0;
+    for (uint8_t b : header) {
+        out[n++] = b;
+    }
+    for (uint16_t col = first; col <= last; col++) {
+        out[n++] = data[col];
+    }
+    // controller issues STOP after this byte and START again for the next region
+    out[n - 1] |= I2C_IC_DATA_CMD_STOP_BITS;
+    return n;
+}
+
+size_t Panel::start_frame(FrameBuffer& frame) {
+    size_t words = 0;
+
+    for (uint8_t page = 0; page < DISPLAY_PAGES; page++) {
+        DirtySpan span = frame.dirty_span(page);
+        // GDDRAM content is unknown, so every page is sent in full once
+        if (!shown_valid) { span = { 0, DISPLAY_WIDTH - 1 }; }
+        if (span.is_clean()) { continue; }
+
+        const uint8_t* data = frame.page_data(page);
+        uint8_t* on_panel = &shown[page * DISPLAY_WIDTH];
+
+        // redraws often produce the same pixels, trim span to bytes that really changed
+        if (shown_valid) {
+            while (span.first <= span.last && data[span.first] == on_panel[span.first]) { span.first++; }
+            while (span.last > span.first && data[span.last] == on_panel[span.last]) { span.last--; }
+            if (span.is_clean()) { continue; }
+        }
+
+        words += serialize_region(stream + words, page, span.first, span.last, data);
+        memcpy(on_panel + span.first, data + span.first, span.last - span.first + 1);
+    }
+
+    frame.clear_dirty();
+    shown_valid = true;
+    bytes_last_frame = words;
+
+    if (words == 0) { return 0; }
+
+    // target address can only be changed while controller is disabled
+    i2c_hw_t* hw = i2c_get_hw(i2c);
+    hw->enable = 0;
+    hw->tar = address;
+    hw->enable = 1;
+
+    dma_channel_transfer_from_buffer_now(dma_channel, stream, words);
+    last_frame_start = time_us_64();
+    return words;
+}
+
+size_t Panel::flush(FrameBuffer& frame) {
+    wait_idle();
+    size_t sent = start_frame(frame);
+    wait_idle();
+    return sent;
+}
+
+size_t Panel::flush_async(FrameBuffer& frame) {
+    if (is_busy()) { return 0; }
+    if (frame_interval_us != 0 && time_us_64() - last_frame_start < frame_interval_us) { return 0; }
+
+    return start_frame(frame);
+}
+
+bool Panel::is_busy() {
+    if (dma_channel_is_busy(dma_channel)) { return true; }
+
+    i2c_hw_t* hw = i2c_get_hw(i2c);
+    if (hw->raw_intr_stat & I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS) {
+        // controller flushed the FIFO, panel content is unknown now
+        (void)hw->clr_tx_abrt;
+        aborted_frames++;
+        shown_valid = false;
+        return false;
+    }
+
+    // DMA is done once the last word is in the FIFO, wait for it to leave the wire too
+    return !(hw->status & I2C_IC_STATUS_TFE_BITS) || (hw->status & I2C_IC_STATUS_MST_ACTIVITY_BITS);
+}
+
+void Panel::wait_idle() {
+    while (is_busy()) {
+        tight_loop_contents();
+    }
+}
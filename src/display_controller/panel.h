@@ -0,0 +1,94 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "hardware/i2c.h"
+#include "hardware/dma.h"
+
+#include "framebuffer.h"
+
+// SSD1306 control bytes & addressing commands
+#define SSD1306_CONTROL_CMD_CONTINUE    0x80
+#define SSD1306_CONTROL_DATA            0x40
+#define SSD1306_CMD_COLUMN_ADDR         0x21
+#define SSD1306_CMD_PAGE_ADDR           0x22
+
+/// bytes in front of every region: 6 command pairs & data control byte
+#define PANEL_REGION_HEADER_BYTES       13
+
+/// worst case frame: every page sent in full, one IC_DATA_CMD word per byte
+#define PANEL_STREAM_WORDS              (DISPLAY_PAGES * (PANEL_REGION_HEADER_BYTES + DISPLAY_WIDTH))
+
+namespace display_controller {
+    /// @brief i2c link to SSD1306 GDDRAM, only sends regions that differ from what the panel already shows.
+    /// Frames are serialized into a word stream that DMA feeds into the i2c TX FIFO, so the framebuffer
+    /// is free for drawing as soon as flush_async() returns. Framebuffer is the back buffer, stream is the front one.
+    class Panel {
+    private:
+        i2c_inst_t* i2c;
+        uint8_t address;
+
+        /// @brief DMA channel feeding IC_DATA_CMD
+        uint dma_channel;
+
+        /// @brief IC_DATA_CMD words of the frame in flight, STOP bit marks end of every region
+        uint16_t stream[PANEL_STREAM_WORDS];
+
+        /// @brief copy of what is currently in the GDDRAM of the panel (or will be once the frame in flight is done)
+        uint8_t shown[DISPLAY_PAGES * DISPLAY_WIDTH];
+
+        /// @brief false until the whole GDDRAM was written once
+        bool shown_valid;
+
+        /// @brief bytes put on the bus by the last flush (control bytes included)
+        size_t bytes_last_frame;
+
+        /// @brief frames that were aborted by the i2c controller (NAK etc.)
+        uint32_t aborted_frames;
+
+        /// @brief minimal time between frame starts in microseconds, 0 for no cap
+        uint32_t frame_interval_us;
+
+        /// @brief timestamp of the last frame start
+        uint64_t last_frame_start;
+
+        /// @brief append one page window [first, last] as a single i2c transaction
+        /// @return number of words appended
+        size_t serialize_region(uint16_t* out, uint8_t page, uint8_t first, uint8_t last, const uint8_t* data);
+
+        /// @brief serialize dirty regions of the frame and kick off DMA
+        size_t start_frame(FrameBuffer& frame);
+
+    public:
+        /// @param i2c initialized i2c controller the panel is connected to
+        /// @param address i2c address of the panel
+        Panel(i2c_inst_t* i2c, uint8_t address);
+
+        /// @brief send all dirty regions of the frame and wait until they're on the panel, ignores frame cap
+        /// @return number of bytes sent over i2c
+        size_t flush(FrameBuffer& frame);
+
+        /// @brief start sending dirty regions of the frame in the background.
+        /// Nothing is sent while previous frame is in flight or frame cap didn't pass, frame then stays dirty.
+        /// @return number of bytes queued for i2c, 0 if nothing was started
+        size_t flush_async(FrameBuffer& frame);
+
+        /// @brief is a frame still being transferred
+        bool is_busy();
+
+        /// @brief block until the frame in flight is on the panel
+        void wait_idle();
+
+        /// @brief forget what the panel shows, next flush resends whole frame
+        void invalidate();
+
+        /// @brief limit how often frames are started
+        /// @param fps max frames per second, 0 to disable the cap
+        void set_frame_rate(uint8_t fps);
+
+        size_t get_bytes_last_frame() const { return bytes_last_frame; }
+
+        uint32_t get_aborted_frames() const { return aborted_frames; }
+    };
+}
@@ -0,0 +1,37 @@
+#include "progress_bar.h"
+
+using namespace display_controller;
+
+ProgressBar::ProgressBar(int16_t x_start, int16_t y_start, int16_t x_end, int16_t y_end) {
+    this->x_start = x_start;
+    this->y_start = y_start;
+    this->x_end = x_end;
+    this->y_end = y_end;
+    filled = 0;
+}
+
+int16_t ProgressBar::columns_for(uint8_t percentage) const {
+    if (percentage > 100) { percentage = 100; }
+    return (x_end - x_start + 1) * percentage / 100;
+}
+
+DirtySpan ProgressBar::changed_columns(uint8_t percentage) const {
+    int16_t columns = columns_for(percentage);
+    if (columns == filled) { return { 0xFF, 0 }; }
+
+    int16_t low = columns < filled ? columns : filled;
+    int16_t high = columns < filled ? filled : columns;
+    return { (uint8_t)(x_start + low), (uint8_t)(x_start + high - 1) };
+}
+
+void ProgressBar::set(FrameBuffer& frame, uint8_t percentage) {
+    int16_t columns = columns_for(percentage);
+
+    if (columns > filled) {
+        frame.fill_rect(x_start + filled, y_start, x_start + columns - 1, y_end, pico_ssd1306::WriteMode::ADD);
+    }
+    else if (columns < filled) {
+        frame.fill_rect(x_start + columns, y_start, x_start + filled - 1, y_end, pico_ssd1306::WriteMode::SUBTRACT);
+    }
+    filled = columns;
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <stdint.h>
+
+#include "framebuffer.h"
+
+namespace display_controller {
+    /// @brief Horizontal bar filled from the left. A new level only rewrites the columns between the old
+    /// and the new end of the fill, e.g. a 1% step of a 122 column bar is one or two columns.
+    class ProgressBar {
+    private:
+        /// @brief fill area, corners are inclusive
+        int16_t x_start;
+        int16_t y_start;
+        int16_t x_end;
+        int16_t y_end;
+
+        /// @brief columns filled from x_start
+        int16_t filled;
+
+        int16_t columns_for(uint8_t percentage) const;
+
+    public:
+        ProgressBar(int16_t x_start, int16_t y_start, int16_t x_end, int16_t y_end);
+
+        /// @brief frame was cleared under the bar, nothing is filled
+        void reset() { filled = 0; }
+
+        /// @brief columns a new level would rewrite, clean span if it doesn't change anything
+        /// @param percentage 0 - 100, more is full
+        DirtySpan changed_columns(uint8_t percentage) const;
+
+        /// @brief move the end of the fill, only the columns in between are written
+        /// @param percentage 0 - 100, more is full
+        void set(FrameBuffer& frame, uint8_t percentage);
+    };
+}
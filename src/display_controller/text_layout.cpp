@@ -0,0 +1,43 @@
+#include "text_layout.h"
+
+using namespace display_controller;
+
+uint8_t display_controller::wrap_lines(std::string_view text, uint8_t line_width, LineSpan* lines, uint8_t max_lines) {
+    uint8_t count = 0;
+    const char* line_start = nullptr;
+    size_t line_length = 0;
+
+    size_t i = 0;
+    while (i < text.size() && count < max_lines) {
+        // skip spaces in front of a word
+        if (text[i] == ' ') {
+            i++;
+            continue;
+        }
+
+        size_t word_start = i;
+        while (i < text.size() && text[i] != ' ') { i++; }
+
+        const char* word = text.data() + word_start;
+        size_t word_length = i - word_start;
+
+        if (line_start == nullptr) {
+            line_start = word;
+            line_length = word_length;
+        }
+        else if ((size_t)(word + word_length - line_start) <= line_width) {
+            // word fits, line grows over the spaces in between
+            line_length = word + word_length - line_start;
+        }
+        else {
+            lines[count++] = { line_start, (uint8_t)(line_length > 255 ? 255 : line_length) };
+            line_start = word;
+            line_length = word_length;
+        }
+    }
+
+    if (line_start != nullptr && count < max_lines) {
+        lines[count++] = { line_start, (uint8_t)(line_length > 255 ? 255 : line_length) };
+    }
+    return count;
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string_view>
+
+namespace display_controller {
+    /// @brief one line of wrapped text, points into the original string
+    struct LineSpan {
+        const char* text;
+        uint8_t length;
+    };
+
+    /// @brief Word-wrap text into spans with length <= line_width, word endings are preserved.
+    /// Exception: If single word is longer than line_width then it's not chopped.
+    /// Nothing is allocated or copied, every character is looked at once.
+    /// @param text text to wrap, words are separated by spaces
+    /// @param line_width max length of one line
+    /// @param lines caller-provided array the spans are written to
+    /// @param max_lines size of lines, text that doesn't fit is dropped
+    /// @return number of lines written
+    uint8_t wrap_lines(std::string_view text, uint8_t line_width, LineSpan* lines, uint8_t max_lines);
+}
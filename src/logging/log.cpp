@@ -0,0 +1,143 @@
+#include "log.h"
+
+#include "hardware/uart.h"
+#include "pico/sync.h"
+#include "pico/stdio_uart.h"
+
+// records are drained to the stdio UART
+#define LOG_UART uart0
+
+static_assert((LOG_BUFFER_SIZE & (LOG_BUFFER_SIZE - 1)) == 0, "log buffer size has to be a power of two");
+static_assert(LOG_HEADER_BYTES + LOG_MAX_TEXT <= LOG_BUFFER_SIZE, "text record has to fit the ring");
+
+namespace logging {
+    static uint8_t ring[LOG_BUFFER_SIZE];
+    /// @brief free running byte counters, head is written by producers & tail by drain()
+    static uint32_t head;
+    static uint32_t tail;
+    static uint32_t dropped;
+    static uint32_t high_water;
+    static uint8_t sequence;
+
+    /// @brief both cores log, records are reserved under this lock
+    static critical_section_t lock;
+    static bool initialized = false;
+
+    /// @brief replaces stdio_uart, output goes into the ring & input still comes from the UART
+    static stdio_driver_t text_driver;
+
+    static void text_out_chars(const char* buf, int length) {
+        write_text(buf, length);
+    }
+
+    void init() {
+        if (!initialized) {
+            critical_section_init(&lock);
+
+            text_driver.out_chars = text_out_chars;
+            text_driver.in_chars = stdio_uart.in_chars;
+#if PICO_STDIO_ENABLE_CRLF_SUPPORT
+            text_driver.crlf_enabled = PICO_STDIO_DEFAULT_CRLF;
+#endif
+            stdio_set_driver_enabled(&stdio_uart, false);
+            stdio_set_driver_enabled(&text_driver, true);
+        }
+        head = 0;
+        tail = 0;
+        dropped = 0;
+        high_water = 0;
+        sequence = 0;
+        initialized = true;
+    }
+
+    static void put(uint32_t pos, const void* data, size_t length) {
+        const uint8_t* bytes = (const uint8_t*)data;
+        for (size_t i = 0; i < length; i++) {
+            ring[(pos + i) % LOG_BUFFER_SIZE] = bytes[i];
+        }
+    }
+
+    void write(uint8_t level, const char* fmt, const uint32_t* args, uint8_t count) {
+        if (!initialized) { return; }
+
+        uint32_t timestamp = time_us_32();
+        uint32_t address = (uint32_t)(uintptr_t)fmt;
+        size_t length = LOG_HEADER_BYTES + sizeof(address) + sizeof(timestamp) + count * sizeof(uint32_t);
+
+        critical_section_enter_blocking(&lock);
+
+        uint32_t used = head - tail;
+        if (used + length > LOG_BUFFER_SIZE) {
+            dropped++;
+            critical_section_exit(&lock);
+            return;
+        }
+
+        uint8_t header[LOG_HEADER_BYTES] = { LOG_SYNC_BYTE, level, count, sequence++ };
+        put(head, header, sizeof(header));
+        put(head + LOG_HEADER_BYTES, &address, sizeof(address));
+        put(head + LOG_HEADER_BYTES + 4, &timestamp, sizeof(timestamp));
+        put(head + LOG_HEADER_BYTES + 8, args, count * sizeof(uint32_t));
+        head += length;
+
+        if (used + length > high_water) { high_water = used + length; }
+
+        critical_section_exit(&lock);
+    }
+
+    /// @brief copy one text record into the ring
+    /// @return false if there's no room for it yet
+    static bool put_text(const char* text, uint8_t length) {
+        critical_section_enter_blocking(&lock);
+
+        uint32_t used = head - tail;
+        if (used + LOG_HEADER_BYTES + length > LOG_BUFFER_SIZE) {
+            critical_section_exit(&lock);
+            return false;
+        }
+
+        uint8_t header[LOG_HEADER_BYTES] = { LOG_SYNC_BYTE, LOG_TEXT, length, sequence++ };
+        put(head, header, sizeof(header));
+        put(head + LOG_HEADER_BYTES, text, length);
+        head += LOG_HEADER_BYTES + length;
+
+        if (head - tail > high_water) { high_water = head - tail; }
+
+        critical_section_exit(&lock);
+        return true;
+    }
+
+    void write_text(const char* text, size_t length) {
+        if (!initialized) { return; }
+
+        while (length > 0) {
+            uint8_t chunk = length > LOG_MAX_TEXT ? LOG_MAX_TEXT : length;
+            // text isn't dropped, the ring makes room as fast as the UART takes bytes
+            while (!put_text(text, chunk)) { drain(); }
+            text += chunk;
+            length -= chunk;
+        }
+    }
+
+    size_t drain() {
+        if (!initialized) { return 0; }
+
+        size_t moved = 0;
+        // only drain() moves tail, head is read once so producers aren't held up
+        uint32_t end = *(volatile uint32_t*)&head;
+        while (tail != end && uart_is_writable(LOG_UART)) {
+            uart_putc_raw(LOG_UART, ring[tail % LOG_BUFFER_SIZE]);
+            tail++;
+            moved++;
+        }
+        return moved;
+    }
+
+    uint32_t get_dropped() {
+        return dropped;
+    }
+
+    uint32_t get_high_water() {
+        return high_water;
+    }
+}
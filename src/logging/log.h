@@ -0,0 +1,119 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+#include "pico/stdlib.h"
+
+#define LOG_LEVEL_NONE      0
+#define LOG_LEVEL_ERROR     1
+#define LOG_LEVEL_WARN      2
+#define LOG_LEVEL_INFO      3
+#define LOG_LEVEL_DEBUG     4
+
+// levels above this one compile to nothing
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+// bytes of RAM for pending records
+#define LOG_BUFFER_SIZE     2048
+// raw argument words of one record, 64 bit values take two
+#define LOG_MAX_ARG_WORDS   16
+// first byte of every record, decoder looks for it before the first record only
+#define LOG_SYNC_BYTE       0xA5
+// sync, level, number of argument words, sequence number
+#define LOG_HEADER_BYTES    4
+// level of a record that holds printf output, its count is the number of text bytes
+#define LOG_TEXT            0x80
+#define LOG_MAX_TEXT        255
+
+/// Deferred binary logging: a record holds the address of its format string (it stays in flash),
+/// a timestamp and raw argument words. Text is rebuilt on the host by tools/log_decoder from the ELF file.
+///
+/// Record layout, little endian:
+/// | 0xA5 | level | n | seq | fmt address (4) | time_us_32 (4) | n argument words (4 each) |
+/// | 0xA5 | LOG_TEXT | n | seq | n bytes of printf output |
+///
+/// printf output goes through the same ring as text records, so it can't end up inside a half sent record.
+namespace logging {
+    /// @brief set up the ring & take the UART out of stdio, records written before are dropped
+    void init();
+
+    /// @brief append a record, never blocks, drops the record if ring is full
+    /// @param level LOG_LEVEL_*
+    /// @param fmt printf format string, has to be a string literal
+    /// @param args encoded arguments
+    /// @param count number of argument words
+    void write(uint8_t level, const char* fmt, const uint32_t* args, uint8_t count);
+
+    /// @brief append printf output as text records, waits for the UART while the ring is full as printf did before.
+    /// Only called on core 0, same as drain()
+    void write_text(const char* text, size_t length);
+
+    /// @brief move pending bytes to the UART until its FIFO is full, never blocks
+    /// @return number of bytes moved
+    size_t drain();
+
+    /// @brief records lost because the ring was full
+    uint32_t get_dropped();
+
+    /// @brief most bytes that were ever pending
+    uint32_t get_high_water();
+
+    // argument encoding, %s and %p arguments are sent as addresses
+    template <typename T>
+    inline void encode(uint32_t* words, uint8_t& n, T value) {
+        if constexpr (std::is_floating_point<T>::value) {
+            float f = value;
+            memcpy(&words[n++], &f, sizeof(f));
+        }
+        else if constexpr (std::is_pointer<T>::value) {
+            words[n++] = (uint32_t)(uintptr_t)value;
+        }
+        else if constexpr (sizeof(T) > sizeof(uint32_t)) {
+            uint64_t v = (uint64_t)value;
+            words[n++] = (uint32_t)v;
+            words[n++] = (uint32_t)(v >> 32);
+        }
+        else {
+            words[n++] = (uint32_t)value;
+        }
+    }
+
+    template <typename... Args>
+    inline void log(uint8_t level, const char* fmt, Args... args) {
+        static_assert(sizeof...(Args) * 2 <= LOG_MAX_ARG_WORDS, "too many log arguments");
+
+        // one spare word keeps the array from being empty, it's never read but has to be initialized for -Wall
+        uint32_t words[sizeof...(Args) * 2 + 1] = {};
+        uint8_t n = 0;
+        (encode(words, n, args), ...);
+        write(level, fmt, words, n);
+    }
+}
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(fmt, ...) ::logging::log(LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+#else
+#define LOG_ERROR(fmt, ...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(fmt, ...) ::logging::log(LOG_LEVEL_WARN, fmt, ##__VA_ARGS__)
+#else
+#define LOG_WARN(fmt, ...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(fmt, ...) ::logging::log(LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#else
+#define LOG_INFO(fmt, ...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(fmt, ...) ::logging::log(LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+#else
+#define LOG_DEBUG(fmt, ...) do {} while (0)
+#endif
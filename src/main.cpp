@@ -1,18 +1,86 @@
 #include <stdio.h>
+#include <string.h>
 
 #include "pico/stdlib.h"
 #include "hardware/i2c.h"
 #include "hardware/adc.h"
 #include "hardware/watchdog.h"
 
-#include "display_controller/display_controller.h"
+#include "display_controller/display_service.h"
 #include "sensors/thermistor.h"
+#include "sensors/fuel_gauge.h"
 #include "charging_protocols/quick_charge.h"
+#include "charging_protocols/pio_data_lines.h"
+#include "scheduler/scheduler.h"
+#include "logging/log.h"
+#include "profiler/profiler.h"
+#include "power/power_manager.h"
+#include "power/power_arbiter.h"
+#include "telemetry/flash_log.h"
+#include "telemetry/usb_stream.h"
 
 #define DISPLAY_SDA_PIN 4
 #define DISPLAY_SCL_PIN 5
+#define DISPLAY_I2C_BAUDRATE 1000000
+// SSD1306 needs this long after power-up, the display task starts core 1 once it passed
+#define DISPLAY_POWER_UP_US (50 * 1000)
 
-#define LOOP_DELAY 100 // in ms
+// task periods in microseconds
+#define CHARGING_PERIOD_US (1000)           // 1kHz
+#define DISPLAY_PERIOD_US (100 * 1000)      // 10Hz
+#define THERMISTOR_PERIOD_US (200 * 1000)   // 5Hz
+#define POWER_PERIOD_US (100 * 1000)        // control period of the power arbiter
+#if FUEL_GAUGE_ENABLED
+#define BATTERY_PERIOD_US (20 * 1000)       // has to stay below ADC_SAMPLER_DEPTH - 2 sample periods
+#endif
+#define REPORT_PERIOD_US (5 * 1000000)
+#define LOG_PERIOD_US (1000)                // UART FIFO holds ~2.7ms at 115200 baud
+#define CONSOLE_PERIOD_US (20 * 1000)
+#define TELEMETRY_PERIOD_US (2 * 1000)      // 500Hz
+// how late tasks may start, flash log erases (~45ms) only happen when every task can wait that long.
+// Charging has no slack while a handshake or mode change is timed, battery gauge integrates over elapsed time
+// so a late run only averages fewer samples
+#define CHARGING_SLACK_US (60 * 1000)
+#if FUEL_GAUGE_ENABLED
+#define BATTERY_SLACK_US (60 * 1000)
+#endif
+#define POWER_SLACK_US (50 * 1000)
+#define DEFAULT_SLACK_US (100 * 1000)
+#define TELEMETRY_TEMPERATURE_PERIOD_US (60 * 1000000)
+// samples per input in an ADC frame, newer ones win if more were taken since the last frame
+#define TELEMETRY_ADC_MAX_SAMPLES 8
+// ports & task timing go with every n-th ADC frame
+#define TELEMETRY_STATUS_EVERY 10
+// periods in night mode, battery keeps its period since the sampler only holds ~30ms of samples
+#define NIGHT_CHARGING_PERIOD_US (50 * 1000)    // bounds wake-up latency
+#define NIGHT_DISPLAY_PERIOD_US (500 * 1000)
+#define NIGHT_THERMISTOR_PERIOD_US (1000000)
+#define NIGHT_LOG_PERIOD_US (10 * 1000)
+#define NIGHT_CONSOLE_PERIOD_US (100 * 1000)
+#define NIGHT_TELEMETRY_PERIOD_US (100 * 1000)
+
+// longest console command
+#define CONSOLE_LINE_LENGTH 32
+
+#define QC_DEMO_PERIOD_US (6 * 1000000)
+// continuous mode targets the demo switches between, within class A
+#define QC_DEMO_HIGH_MV 11800
+#define QC_DEMO_LOW_MV 7400
+// shared by all ports, derated above 60C, everything drops to 5v at 80C
+#define POWER_BUDGET_MW 36000
+#define POWER_DERATE_CENTI 6000
+#define POWER_PANIC_CENTI 8000
+#define POWER_KP_MW_PER_C 1000
+#define POWER_KI_MW_PER_C_S 200
+// USB-A ports are rated 2A, USB-C 3A
+#define PORT_A_CURRENT_MA 2000
+#define PORT_B_CURRENT_MA 2000
+#define PORT_C_CURRENT_MA 3000
+// fed while every task finished within 2 of its own periods, so a hung task is caught after that. Has to be longer
+// than the longest stall of the main loop: a single task run or a flash erase (FLASH_LOG_ERASE_US)
+#define WATCHDOG_TIMEOUT_MS 500
+// after a watchdog reset every port is held at 5v this long
+#define WATCHDOG_SAFE_HOLD_US (30 * 1000000u)
 
 #define WATER_SENSOR_AC1 17
 #define WATER_SENSOR_AC2 18
@@ -20,8 +88,35 @@
 
 #define ONBOARD_TEMP_PIN 26
 
+// pulled up, pressing it ends night mode
+#define WAKE_BUTTON_PIN 21
+
 #define THERMISTOR_A_PIN 26
+#define THERMISTOR_A_ADC 0
+
 #define THERMISTOR_B_PIN 27
+#define THERMISTOR_B_ADC 1
+
+#if FUEL_GAUGE_ENABLED
+// board has no battery sense circuit yet, its inputs & calibration come from the build (see CMakeLists.txt)
+#if !defined(BATTERY_SENSE_ADC) || !defined(BATTERY_MUX_PIN) || !defined(BATTERY_CAPACITY_MAH) || \
+	!defined(BATTERY_CELLS) || !defined(BATTERY_ZERO_RAW) || !defined(BATTERY_UA_PER_COUNT) || \
+	!defined(BATTERY_UV_PER_COUNT)
+#error "fuel gauge needs BATTERY_SENSE_ADC, BATTERY_MUX_PIN & the BATTERY_* calibration of the sense circuit"
+#endif
+#ifndef BATTERY_REST_MA
+#define BATTERY_REST_MA 50
+#endif
+#ifndef BATTERY_REST_US
+#define BATTERY_REST_US (10 * 60 * 1000000u)
+#endif
+#define BATTERY_ADC_MASK	(1 << BATTERY_SENSE_ADC)
+#else
+#define BATTERY_ADC_MASK	0
+#endif
+
+// per channel, ADC sweeps thermistors & temperature sensor in the background
+#define ADC_SAMPLE_RATE_HZ 1000
 
 #define QC_A_DM_LOW 	8
 #define QC_A_DM_HIGH 	9
@@ -32,102 +127,475 @@
 #define QC_B_DP_HIGH 	13
 #define QC_B_DM_LOW 	14
 #define QC_B_DM_HIGH 	15
+#if QC_SINK_DETECTOR_ENABLED
+// port B is a QC source, board has to bring the sink's D+/D- to GPIO 28/29
+#define QC_B_DP_ADC		2
+#define QC_B_DM_ADC		3
+#define QC_B_ADC_MASK	((1 << QC_B_DP_ADC) | (1 << QC_B_DM_ADC))
+#else
+#define QC_B_ADC_MASK	0
+#endif
 
+#if FUEL_GAUGE_ENABLED
+static_assert(!(BATTERY_ADC_MASK & ((1 << THERMISTOR_A_ADC) | (1 << THERMISTOR_B_ADC) | QC_B_ADC_MASK)),
+	"battery sense input is taken");
+#endif
 
 
-int main() {
-	if (watchdog_caused_reboot()) {
-		printf("Rebooted by Watchdog!\n");
-		return 0;
+
+// display runs on core 1, core 0 only posts commands
+static display_controller::DisplayService display(i2c0, 0x3C, 5, 20);
+static sensors::Thermistor* t1;
+static sensors::Thermistor* t2;
+static charging_protocols::QuickChargePort_alt* qc_a;
+static charging_protocols::QuickChargePort_alt* qc_b;
+static scheduler::Scheduler tasks;
+static power::PowerManager power_manager;
+static power::PowerArbiter arbiter({
+	POWER_BUDGET_MW, POWER_DERATE_CENTI, POWER_PANIC_CENTI, POWER_KP_MW_PER_C, POWER_KI_MW_PER_C_S, POWER_PERIOD_US });
+// thermistors & chip temperature, read by the power task
+static int32_t board_a_centi, board_b_centi, chip_centi;
+// voltage the QC demo wants on port A, the arbiter decides how much of it is granted
+static uint16_t qc_demo_mv = QC_DEMO_HIGH_MV;
+// task ids, periods change with power state
+static int charging_id, thermal_id, display_id, log_id, console_id, telemetry_id;
+// survives reboots, written in idle windows of the main loop
+static telemetry::FlashLog flash_log;
+// live frames for tools/telemetry_receiver
+static telemetry::UsbStream usb_stream;
+// ports are held at 5v until then, set after a watchdog reset
+static uint64_t safe_until = 0;
+// what the watchdog caught, shown once the display is up
+static char crash_details[64];
+static bool display_started = false;
+static sensors::AdcSampler adc_sampler(
+	(1 << THERMISTOR_A_ADC) | (1 << THERMISTOR_B_ADC) | QC_B_ADC_MASK | BATTERY_ADC_MASK |
+	(1 << ADC_TEMPERATURE_INPUT),
+	ADC_SAMPLE_RATE_HZ);
+#if FUEL_GAUGE_ENABLED
+static sensors::FuelGauge battery(&adc_sampler, ADC_SAMPLE_RATE_HZ, {
+	BATTERY_CAPACITY_MAH, BATTERY_CELLS, BATTERY_SENSE_ADC, BATTERY_SENSE_ADC, BATTERY_MUX_PIN,
+	BATTERY_ZERO_RAW, BATTERY_UA_PER_COUNT, BATTERY_UV_PER_COUNT, BATTERY_REST_MA, BATTERY_REST_US });
+#endif
+
+// probes leave profiler::Stage ids as breadcrumbs
+static const char* stage_name(uint8_t stage) {
+	return stage < (uint8_t)profiler::Stage::COUNT ? profiler::Stage_string[stage] : "-";
+}
+
+// night mode stretches task periods, the main loop then sleeps between releases
+static void apply_power_state(power::PowerState state) {
+	bool night = state == power::PowerState::Night;
+	// clock just changed, PIO holds of a handshake have to keep their length
+	qc_a->clock_changed();
+	qc_b->clock_changed();
+	tasks.set_period(charging_id, night ? NIGHT_CHARGING_PERIOD_US : CHARGING_PERIOD_US);
+	tasks.set_period(thermal_id, night ? NIGHT_THERMISTOR_PERIOD_US : THERMISTOR_PERIOD_US);
+	tasks.set_period(display_id, night ? NIGHT_DISPLAY_PERIOD_US : DISPLAY_PERIOD_US);
+	tasks.set_period(log_id, night ? NIGHT_LOG_PERIOD_US : LOG_PERIOD_US);
+	tasks.set_period(console_id, night ? NIGHT_CONSOLE_PERIOD_US : CONSOLE_PERIOD_US);
+	tasks.set_period(telemetry_id, night ? NIGHT_TELEMETRY_PERIOD_US : TELEMETRY_PERIOD_US);
+	display.post_night_mode(night);
+}
+
+static void charging_task(void*) {
+	PROFILE_SCOPE(profiler::Stage::QC);
+	static uint64_t qc_timer = time_us_64() + QC_DEMO_PERIOD_US;
+	static bool qc_high = true;
+
+	uint64_t now = time_us_64();
+	qc_a->poll(now);
+	qc_b->poll(now);
+	tasks.set_slack(charging_id, qc_a->is_busy() || qc_b->is_busy() ? 0 : CHARGING_SLACK_US);
+
+	// ----QC TESTING----
+	if (qc_timer <= now) {
+		qc_demo_mv = qc_high ? QC_DEMO_HIGH_MV : QC_DEMO_LOW_MV;
+		// port clamps it to the granted voltage
+		qc_a->request_millivolts(qc_demo_mv);
+		qc_high = !qc_high;
+		qc_timer = now + QC_DEMO_PERIOD_US;
 	}
-	else {
-		printf("Clean boot\n");
+
+	// Type-C has no driver yet
+	charging_protocols::PortState ports[] = { qc_a->get_state(), qc_b->get_state(), charging_protocols::PORT_STATE_DISCONNECTED };
+	if (power_manager.update(ports, DISPLAY_PORT_COUNT, now)) {
+		apply_power_state(power_manager.get_state());
 	}
+	profiler::boot_mark(profiler::BootPhase::CHARGING);
+}
 
-	// Enable the watchdog, requiring the watchdog to be updated every 100ms, else the chip will reboot
-	stdio_init_all();
-	adc_init();
-	adc_set_temp_sensor_enabled(true);
+// posts a port only when its snapshot changed, a full queue is retried on the next run
+static void publish_port(uint8_t port, const charging_protocols::PortState& state) {
+	static charging_protocols::PortState posted[DISPLAY_PORT_COUNT];
+	static uint8_t posted_mask = 0;
+
+	if ((posted_mask & (1 << port)) && posted[port] == state) { return; }
+	if (display.post_port_state(port, state)) {
+		posted[port] = state;
+		posted_mask |= 1 << port;
+
+		int32_t raw;
+		memcpy(&raw, &state, sizeof(raw));
+		flash_log.append(telemetry::RecordType::PortState, port, 0, raw);
+	}
+}
+
+// errors are kept in the flash log as well, message has to be a string literal
+static void show_error(const char* msg, const char* details) {
+	display.post_error(msg, details);
+	flash_log.append(telemetry::RecordType::Error, 0, 0, (int32_t)(uintptr_t)msg);
+}
 
-	// Init i2c0 controller
-	i2c_init(i2c0, 1000000);
-	// Set up i2c pins
+// core 1 initializes the panel & owns i2c0 from now on, nothing waits for it
+static void start_display() {
+	i2c_init(i2c0, DISPLAY_I2C_BAUDRATE);
+	power_manager.set_i2c(i2c0, DISPLAY_I2C_BAUDRATE);
 	gpio_set_function(DISPLAY_SDA_PIN, GPIO_FUNC_I2C);
 	gpio_set_function(DISPLAY_SCL_PIN, GPIO_FUNC_I2C);
 	gpio_pull_up(DISPLAY_SDA_PIN);
 	gpio_pull_up(DISPLAY_SCL_PIN);
 
-	// delay for i2c to keep up 
-	sleep_ms(50);
+	display.start();
+	display.post_main_menu();
+	if (crash_details[0] != '\0') {
+		show_error("watchdog", crash_details);
+	}
+	display_started = true;
+	profiler::boot_mark(profiler::BootPhase::DISPLAY);
+}
+
+static void display_task(void*) {
+	static uint64_t msg_timer = time_us_64() + 10 * 1000000;
+
+	if (!display_started) {
+		if (time_us_64() < DISPLAY_POWER_UP_US) { return; }
+		start_display();
+	}
+
+#if FUEL_GAUGE_ENABLED
+	static int posted_battery = -1;
+	int percentage = battery.get_percentage();
+	if (percentage != posted_battery && display.post_battery(percentage)) {
+		posted_battery = percentage;
+	}
+#endif
+
+	publish_port(0, qc_a->get_state());
+	publish_port(1, qc_b->get_state());
+	// Type-C has no driver yet
+	publish_port(2, charging_protocols::PORT_STATE_DISCONNECTED);
+
+	// ---- DISPLAY TESTING ----
+	if (msg_timer <= time_us_64()) {
+		show_error("ligma balls", " aslk dj lk jaeioj apr3 98r p;iha jksdh 7hcj ,zn mxb3hb ");
+		msg_timer = time_us_64() + 10 * 1000000;
+	}
+}
+
+static void thermistor_task(void*) {
+	// ---- SENSORS TESTING ----
+	LOG_INFO("Temperature A: %ld.%02ldC\n", (long)(board_a_centi / 100), (long)(board_a_centi < 0 ? -board_a_centi : board_a_centi) % 100);
+	LOG_INFO("Temperature B: %ld.%02ldC\n", (long)(board_b_centi / 100), (long)(board_b_centi < 0 ? -board_b_centi : board_b_centi) % 100);
+	LOG_INFO("Chip temperature: %ld.%02ldC\n", (long)(chip_centi / 100), (long)(chip_centi < 0 ? -chip_centi : chip_centi) % 100);
+}
+
+// voltage a port wants, continuous mode of a sink isn't followed so the class limit is assumed
+static uint16_t port_demand(ChargingModes mode) {
+	if (mode == ChargingModes::NotConnected) { return 0; }
+	if (mode == ChargingModes::QC_Var) { return QC3_CLASS_A_MAX_VOLTAGE_MV; }
+	return charging_protocols::mode_millivolts(mode);
+}
+
+static bool in_safe_hold() {
+	return time_us_64() < safe_until;
+}
+
+static void apply_grant(charging_protocols::QuickChargePort_alt* port, uint8_t id) {
+	if (arbiter.is_panic() || in_safe_hold()) {
+		if (!(port->get_state().faults & charging_protocols::PORT_FAULT_PANIC)) { port->panic(); }
+	}
+	else {
+		port->clear_fault(charging_protocols::PORT_FAULT_PANIC);
+	}
+
+	if (arbiter.is_limited(id) || arbiter.is_panic()) { port->set_fault(charging_protocols::PORT_FAULT_OVERTEMP); }
+	else { port->clear_fault(charging_protocols::PORT_FAULT_OVERTEMP); }
+
+	uint16_t grant = arbiter.get_grant(id);
+	if (grant > 0) { port->set_voltage_limit(grant); }
+}
+
+// fixed-rate control loop: temperature -> budget -> per port voltage limits
+static void power_task(void*) {
+	PROFILE_SCOPE(profiler::Stage::SENSORS);
+	// ring is zeros right after boot, ports keep their 5v limit until it holds real samples
+	if (!adc_sampler.has_samples(ADC_SAMPLER_DEPTH)) { return; }
+
+	board_a_centi = t1->get_average_centi();
+	board_b_centi = t2->get_average_centi();
+	int32_t board_centi = board_a_centi > board_b_centi ? board_a_centi : board_b_centi;
+	// RP2040 datasheet: T = 27 - (V - 0.706) / 0.001721
+	int32_t millivolts = adc_sampler.average(ADC_TEMPERATURE_INPUT, 16) * 3300 / 4096;
+	chip_centi = 2700 - (millivolts - 706) * 100000 / 1721;
+
+	static uint64_t telemetry_timer = 0;
+	if (telemetry_timer <= time_us_64()) {
+		flash_log.append(telemetry::RecordType::Temperature, 0, chip_centi, board_centi);
+		telemetry_timer = time_us_64() + TELEMETRY_TEMPERATURE_PERIOD_US;
+	}
+
+	// port A follows the demo, port B its adapter or sink, Type-C has no driver yet
+	uint16_t demand_a = port_demand(qc_a->get_mode());
+	if (qc_a->is_qc()) { demand_a = qc_demo_mv; }
+	arbiter.set_demand(0, demand_a);
+	arbiter.set_demand(1, port_demand(qc_b->get_requested_mode()));
+	arbiter.set_demand(2, 0);
+
+	bool changed = arbiter.update(board_centi > chip_centi ? board_centi : chip_centi);
+	apply_grant(qc_a, 0);
+	apply_grant(qc_b, 1);
+
+	// limit only steps down, a higher grant has to be requested again, as after the hold of a watchdog reset
+	static bool was_held = in_safe_hold();
+	bool held = in_safe_hold();
+	if ((changed || was_held) && !held && qc_a->is_qc() && !arbiter.is_panic()) {
+		qc_a->request_millivolts(qc_demo_mv);
+	}
+	was_held = held;
+}
+
+#if FUEL_GAUGE_ENABLED
+static void battery_task(void*) {
+	PROFILE_SCOPE(profiler::Stage::SENSORS);
+	battery.update(time_us_64());
+}
+#endif
+
+static void log_task(void*) {
+	PROFILE_SCOPE(profiler::Stage::LOG);
+	logging::drain();
+}
+
+// streams whatever was sampled since the last run, frames are dropped rather than waited for
+static void telemetry_task(void*) {
+	PROFILE_SCOPE(profiler::Stage::USB);
+	static uint64_t adc_sent_us = time_us_64();
+	static uint8_t runs = 0;
+
+	uint64_t now = time_us_64();
+	if (!usb_stream.is_connected()) {
+		adc_sent_us = now;
+		return;
+	}
+
+	// samples taken since the last frame, whole sample periods only so none is sent twice
+	uint64_t samples = (now - adc_sent_us) * ADC_SAMPLE_RATE_HZ / 1000000;
+	if (samples > TELEMETRY_ADC_MAX_SAMPLES) {
+		samples = TELEMETRY_ADC_MAX_SAMPLES;
+		adc_sent_us = now;
+	}
+	else {
+		adc_sent_us += samples * 1000000 / ADC_SAMPLE_RATE_HZ;
+	}
+	if (samples > 0) { usb_stream.send_adc(adc_sampler, samples); }
+
+	if (++runs >= TELEMETRY_STATUS_EVERY) {
+		runs = 0;
+		charging_protocols::PortState ports[] = { qc_a->get_state(), qc_b->get_state(), charging_protocols::PORT_STATE_DISCONNECTED };
+		usb_stream.send_ports(ports, DISPLAY_PORT_COUNT);
+		usb_stream.send_timing(tasks, tasks.get_task_count());
+	}
+}
+
+static void console_execute(const char* line) {
+	if (strcmp(line, "profile") == 0) {
+		profiler::dump();
+	}
+	else if (strcmp(line, "boot") == 0) {
+		profiler::boot_dump();
+	}
+	else if (strcmp(line, "profile reset") == 0) {
+		profiler::reset();
+		printf("profile cleared\n");
+	}
+	else if (line[0] != '\0') {
+		printf("unknown command: %s\n", line);
+	}
+}
+
+static void console_task(void*) {
+	static char line[CONSOLE_LINE_LENGTH];
+	static uint8_t length = 0;
 
-	// Using display with 0x3C address!
-	pico_ssd1306::SSD1306 display_driver = pico_ssd1306::SSD1306(i2c0, 0x3C, pico_ssd1306::Size::W128xH64);
+	// only takes what already arrived, commands are ended by a new line
+	int c;
+	while ((c = getchar_timeout_us(0)) != PICO_ERROR_TIMEOUT) {
+		if (c == '\r' || c == '\n') {
+			line[length] = '\0';
+			console_execute(line);
+			length = 0;
+		}
+		else if (length < CONSOLE_LINE_LENGTH - 1) {
+			line[length++] = c;
+		}
+	}
+}
+
+static void report_task(void*) {
+	// ---- TECHNICAL ----
+	static bool boot_reported = false;
+	printf("time since start: %dms\n", (int)(time_us_64() / 1000));
+	if (!boot_reported && display_started) {
+		profiler::boot_dump();
+		boot_reported = true;
+	}
+	tasks.report();
+	printf("display queue high water: %lu dropped: %lu core 1 heartbeat: %lu\n",
+		(unsigned long)display.get_high_water(), (unsigned long)display.get_dropped(),
+		(unsigned long)display.get_heartbeat());
+#if FUEL_GAUGE_ENABLED
+	uint16_t time_to_empty = battery.get_time_to_empty();
+	printf("battery: %u%% %umV %ldmA time to empty: ", battery.get_percentage(), battery.get_voltage(), (long)battery.get_current());
+	if (time_to_empty == FUEL_GAUGE_UNKNOWN_TIME) { printf("-\n"); }
+	else { printf("%umin\n", time_to_empty); }
+#endif
+	printf("log high water: %lu bytes dropped: %lu records\n",
+		(unsigned long)logging::get_high_water(), (unsigned long)logging::get_dropped());
+	printf("flash log: sector %u slot %u pending %u dropped %lu\n", flash_log.get_sector(), flash_log.get_slot(),
+		flash_log.get_pending(), (unsigned long)flash_log.get_dropped());
+	printf("usb telemetry: %s sent %lu dropped %lu frames\n", usb_stream.is_connected() ? "connected" : "closed",
+		(unsigned long)usb_stream.get_sent(), (unsigned long)usb_stream.get_dropped());
+}
+
+int main() {
+	// left before the reset, tasks & probes overwrite them from now on
+	scheduler::Breadcrumb breadcrumb;
+	bool has_breadcrumb = scheduler::take_breadcrumb(breadcrumb);
+	bool watchdog_reboot = watchdog_caused_reboot();
+
+	stdio_init_all();
+	usb_stream.begin();
+	logging::init();
+	profiler::init_core();
+	profiler::boot_mark(profiler::BootPhase::STDIO);
+
+	// ---- charging first, ports start at 5v and only grants of the power task raise them ----
+	adc_init();
+	adc_set_temp_sensor_enabled(true);
+	adc_sampler.start();
 
-	display_controller::Display display(&display_driver, 5);
+	// resistor pins in order: D+ high, D+ low, D- high, D- low. Each port has its own state machine of pio0,
+	// levels, holds & pulse trains are timed there
+	static charging_protocols::PioDataLines<QC_A_DP_LOW, QC_A_DP_HIGH, QC_A_DM_LOW, QC_A_DM_HIGH> lines_a(pio0);
+	charging_protocols::QuickChargePort_alt port_a(&lines_a);
+	qc_a = &port_a;
 
-	display.main_menu();
+	static charging_protocols::PioDataLines<QC_B_DP_LOW, QC_B_DP_HIGH, QC_B_DM_LOW, QC_B_DM_HIGH> lines_b(pio0);
+	charging_protocols::QuickChargePort_alt port_b(&lines_b);
+	qc_b = &port_b;
 
-	// Init thermistor
+	// both ports negotiate with their adapters at the same time, charging task advances them
+	qc_a->set_voltage_limit(0);
+	qc_b->set_voltage_limit(0);
+	qc_a->begin();
+#if QC_SINK_DETECTOR_ENABLED
+	// port B gives power to a sink instead
+	qc_b->begin_output(&adc_sampler, QC_B_DP_ADC, QC_B_DM_ADC);
+#else
+	qc_b->begin();
+#endif
+	if (watchdog_reboot) {
+		// whatever hung may have been driving a port up, nothing goes above 5v for a while
+		safe_until = time_us_64() + WATCHDOG_SAFE_HOLD_US;
+		qc_a->panic();
+		qc_b->panic();
+	}
+	// priority order: USB1, USB2, USBC
+	arbiter.add_port(PORT_A_CURRENT_MA);
+	arbiter.add_port(PORT_B_CURRENT_MA);
+	arbiter.add_port(PORT_C_CURRENT_MA);
+	power_manager.begin(1 << WAKE_BUTTON_PIN);
+	profiler::boot_mark(profiler::BootPhase::PORTS);
+
+	flash_log.begin();
+	flash_log.append(telemetry::RecordType::Boot, 0, 0, watchdog_reboot);
+	if (watchdog_reboot && has_breadcrumb) {
+		flash_log.append(telemetry::RecordType::Watchdog, breadcrumb.task, breadcrumb.late_task,
+			breadcrumb.stage[0] | breadcrumb.stage[1] << 8);
+	}
+	profiler::boot_mark(profiler::BootPhase::FLASH_LOG);
+
+#if FUEL_GAUGE_ENABLED
+	battery.begin(time_us_64());
+#endif
+
+	// Init thermistors
 	gpio_init(16);
 	gpio_set_dir(16, true);
 	gpio_put(16, true);
-	sensors::Thermistor t1(THERMISTOR_A_PIN, 1, 100000, 100000, 3950);
-
-	// charging_protocols::QuickChargePort qc_port(16, 17);
-
-	charging_protocols::DigitalPin dm(QC_A_DM_LOW, QC_A_DM_HIGH);
-	charging_protocols::DigitalPin dp(QC_A_DP_LOW, QC_A_DP_HIGH);
-	charging_protocols::QuickChargePort_alt qc(dm, dp);
+	sensors::Thermistor thermistor_a(THERMISTOR_A_PIN, THERMISTOR_A_ADC, 100000, 100000, 3950);
+	thermistor_a.set_lookup(sensors::ThermistorTable<100000, 100000, 3950>::centi_celsius);
+	thermistor_a.set_source(&adc_sampler);
+	t1 = &thermistor_a;
+	// same part as A
+	sensors::Thermistor thermistor_b(THERMISTOR_B_PIN, THERMISTOR_B_ADC, 100000, 100000, 3950);
+	thermistor_b.set_lookup(sensors::ThermistorTable<100000, 100000, 3950>::centi_celsius);
+	thermistor_b.set_source(&adc_sampler);
+	t2 = &thermistor_b;
+	profiler::boot_mark(profiler::BootPhase::SENSORS);
 
-	int i = 0;
-	int port_mode = 0;
+	// registration order is priority
+	charging_id = tasks.add("charging", charging_task, nullptr, CHARGING_PERIOD_US);
+#if FUEL_GAUGE_ENABLED
+	int battery_id = tasks.add("battery", battery_task, nullptr, BATTERY_PERIOD_US);
+#endif
+	int power_id = tasks.add("power", power_task, nullptr, POWER_PERIOD_US);
+	thermal_id = tasks.add("thermal", thermistor_task, nullptr, THERMISTOR_PERIOD_US);
+	display_id = tasks.add("display", display_task, nullptr, DISPLAY_PERIOD_US);
+	tasks.add("report", report_task, nullptr, REPORT_PERIOD_US);
+	log_id = tasks.add("log", log_task, nullptr, LOG_PERIOD_US);
+	console_id = tasks.add("console", console_task, nullptr, CONSOLE_PERIOD_US);
+	telemetry_id = tasks.add("telemetry", telemetry_task, nullptr, TELEMETRY_PERIOD_US);
+	for (int id = 0; id < SCHEDULER_MAX_TASKS; id++) {
+		tasks.set_slack(id, DEFAULT_SLACK_US);
+	}
+	tasks.set_slack(charging_id, CHARGING_SLACK_US);
+#if FUEL_GAUGE_ENABLED
+	tasks.set_slack(battery_id, BATTERY_SLACK_US);
+#endif
+	tasks.set_slack(power_id, POWER_SLACK_US);
 
-	uint64_t msg_timer = time_us_64() + 10 * 1000000;
-	bool msg_switch = true;
+	// Enable the watchdog, it's only updated while every task keeps its rate, else the chip will reboot
+	watchdog_enable(WATCHDOG_TIMEOUT_MS, true);
+	profiler::boot_mark(profiler::BootPhase::TASKS);
 
-	// turned off while debugging
-	// watchdog_enable(25 + LOOP_DELAY, true);
+	// binary log doesn't wait for the UART, the first charging run isn't held back
+	if (watchdog_reboot) {
+		LOG_ERROR("rebooted by watchdog, task %s late task %s stage %s core 1 stage %s\n",
+			tasks.get_name(breadcrumb.task), tasks.get_name(breadcrumb.late_task),
+			stage_name(breadcrumb.stage[0]), stage_name(breadcrumb.stage[1]));
+		// display shows it once it's up
+		snprintf(crash_details, sizeof(crash_details), "task %s stage %s, ports stay at 5v for %us",
+			tasks.get_name(breadcrumb.task != BREADCRUMB_NONE ? breadcrumb.task : breadcrumb.late_task),
+			stage_name(breadcrumb.stage[0]), WATCHDOG_SAFE_HOLD_US / 1000000);
+	}
+	else {
+		LOG_INFO("clean boot\n");
+	}
 	while (true) {
-		// timing loop length
-		double start_time = time_us_64();
-
-		gpio_put(21, true);
-		// ---- DISPLAY TESTING ----
-		if (true) {
-			display.update_port_a(port_mode);
-			display.update_port_b(port_mode);
-			display.update_port_c(port_mode + 6);
-			display.update_battery(i);
-			i++;
-			if (i >= 120) { i = 0; }
-			port_mode++;
-			if (port_mode >= 5) {
-				port_mode = 0;
-			}
-
-			if (msg_timer <= time_us_64()) {
-				display.error("ligma balls", " aslk dj lk jaeioj apr3 98r p;iha jksdh 7hcj ,zn mxb3hb ");
-				msg_timer = time_us_64() + 10 * 1000000;
-			}
+		uint64_t now = time_us_64();
+		tasks.run_pending(now);
+		{
+			PROFILE_SCOPE(profiler::Stage::WATCHDOG);
+			tasks.feed_watchdog(now);
+		}
+		// flash writes park core 1, records wait in RAM until the display task launched it
+		if (display_started) {
+			PROFILE_SCOPE(profiler::Stage::FLASH);
+			flash_log.commit(tasks.idle_window(time_us_64()));
 		}
-		// ----QC TESTING----
-		qc.begin();
-		qc.request(ChargingModes::QC_20v);
-		sleep_ms(6000);
-		qc.request(ChargingModes::QC_12v);
-		sleep_ms(6000);
-		// ---- SENSORS TESTING ----
-		printf("Temperature: %.2fC\n", t1.get());
-
-		// ---- TECHNICAL ----
-		printf("---- MAIN LOOP END ----\n");
-		int end_time = time_us_64();
-		float executionTime = ((end_time - start_time)) / 1000;
-		printf("time since start: %dms\nloop time: %.3fms\n", (int)(time_us_64() / 1000), executionTime);
-
-
-		watchdog_update();
-		sleep_ms(LOOP_DELAY);
+		// no tick, core sleeps until the next task is due or an interrupt comes
+		power_manager.idle_until(tasks.next_release());
 	};
 }
-
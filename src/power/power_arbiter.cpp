@@ -0,0 +1,109 @@
+#include "power_arbiter.h"
+
+#include "../logging/log.h"
+
+using namespace power;
+
+static_assert(POWER_ARBITER_BASE_MV % POWER_ARBITER_STEP_MV == 0, "base voltage has to be a whole step");
+
+PowerArbiter::PowerArbiter(const PowerArbiterConfig& config) {
+    this->config = config;
+    port_count = 0;
+    integral_q16 = 0;
+    // mW/C/s -> mW per centi-degree per period
+    ki_step_q16 = ((int64_t)config.ki_mw_per_c_s << 16) * config.period_us / (100 * 1000000ll);
+    budget_mw = config.budget_mw;
+    panic = false;
+}
+
+int PowerArbiter::add_port(uint16_t current_ma) {
+    if (port_count >= POWER_ARBITER_MAX_PORTS) {
+        LOG_ERROR("power arbiter is full\n");
+        return -1;
+    }
+
+    ports[port_count] = { current_ma, 0, 0 };
+    return port_count++;
+}
+
+void PowerArbiter::set_demand(uint8_t port, uint16_t millivolts) {
+    if (port >= port_count) { return; }
+    ports[port].demand_mv = millivolts;
+}
+
+void PowerArbiter::derate(int32_t centi) {
+    int32_t error = centi - config.derate_centi;
+    const int64_t max_q16 = (int64_t)config.budget_mw << 16;
+
+    // integral stays within what can be taken away, so it doesn't wind up while the board is cool or saturated
+    integral_q16 += ki_step_q16 * error;
+    if (integral_q16 < 0) { integral_q16 = 0; }
+    if (integral_q16 > max_q16) { integral_q16 = max_q16; }
+
+    int64_t derating_q16 = integral_q16 + ((int64_t)config.kp_mw_per_c * error << 16) / 100;
+    if (derating_q16 < 0) { derating_q16 = 0; }
+    if (derating_q16 > max_q16) { derating_q16 = max_q16; }
+
+    budget_mw = config.budget_mw - (uint32_t)(derating_q16 >> 16);
+}
+
+bool PowerArbiter::allocate() {
+    // 5v of every connected port comes first, it can't be refused
+    uint32_t left = budget_mw;
+    for (uint8_t port = 0; port < port_count; port++) {
+        const PortBudget& budget = ports[port];
+        uint16_t base = budget.demand_mv < POWER_ARBITER_BASE_MV ? budget.demand_mv : POWER_ARBITER_BASE_MV;
+        uint32_t base_mw = (uint32_t)base * budget.current_ma / 1000;
+        left = left > base_mw ? left - base_mw : 0;
+    }
+
+    bool changed = false;
+    for (uint8_t port = 0; port < port_count; port++) {
+        PortBudget& budget = ports[port];
+        uint16_t grant = 0;
+
+        if (budget.demand_mv > 0) {
+            uint16_t base = budget.demand_mv < POWER_ARBITER_BASE_MV ? budget.demand_mv : POWER_ARBITER_BASE_MV;
+            uint32_t allowed = POWER_ARBITER_BASE_MV;
+            if (!panic && budget.current_ma > 0) {
+                allowed += left * 1000 / budget.current_ma;
+                allowed -= allowed % POWER_ARBITER_STEP_MV;
+            }
+            if (allowed > budget.demand_mv) { allowed = budget.demand_mv; }
+
+            // newly connected ports ramp up from 5v too
+            uint32_t from = budget.grant_mv > 0 ? budget.grant_mv : base;
+            if (allowed > from + POWER_ARBITER_RAMP_MV) { allowed = from + POWER_ARBITER_RAMP_MV; }
+
+            grant = allowed;
+            uint32_t extra_mw = (uint32_t)(grant > base ? grant - base : 0) * budget.current_ma / 1000;
+            left = left > extra_mw ? left - extra_mw : 0;
+        }
+
+        if (grant != budget.grant_mv) {
+            LOG_DEBUG("port %d granted %umV of %umV\n", port, grant, budget.demand_mv);
+            budget.grant_mv = grant;
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+bool PowerArbiter::update(int32_t centi) {
+    bool was_panic = panic;
+    if (centi >= config.panic_centi) { panic = true; }
+    else if (centi < config.panic_centi - POWER_ARBITER_PANIC_HYSTERESIS_CENTI) { panic = false; }
+
+    if (panic != was_panic) {
+        if (panic) { LOG_ERROR("board at %ld.%02ldC, ports fall back to 5v\n", (long)(centi / 100), (long)(centi % 100)); }
+        else { LOG_INFO("board cooled down, ports are released\n"); }
+    }
+
+    derate(centi);
+    return allocate() || panic != was_panic;
+}
+
+bool PowerArbiter::is_limited(uint8_t port) const {
+    const PortBudget& budget = ports[port];
+    return budget.grant_mv < budget.demand_mv && (budget_mw < config.budget_mw || panic);
+}
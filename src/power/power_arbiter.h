@@ -0,0 +1,95 @@
+#pragma once
+
+#include <stdio.h>
+
+#include "pico/stdlib.h"
+
+// USB1, USB2 & USBC
+#define POWER_ARBITER_MAX_PORTS 3
+// every connected port gets up to this voltage whatever the budget is, USB doesn't go lower
+#define POWER_ARBITER_BASE_MV 5000
+// grants are multiples of a QC3.0 continuous mode step
+#define POWER_ARBITER_STEP_MV 200
+// grants rise at most this much per control period, they drop at once
+#define POWER_ARBITER_RAMP_MV 1000
+// panic ends once the board cooled this much below panic temperature, in centi-degrees
+#define POWER_ARBITER_PANIC_HYSTERESIS_CENTI 500
+
+namespace power {
+    struct PowerArbiterConfig {
+        /// @brief power shared by all ports while the board is cool
+        uint32_t budget_mw;
+        /// @brief setpoint of the PI loop, budget is derated above it
+        int32_t derate_centi;
+        /// @brief every port falls back to 5v above it
+        int32_t panic_centi;
+        /// @brief budget taken away per degree above setpoint
+        int32_t kp_mw_per_c;
+        /// @brief budget taken away per degree above setpoint & second it stays there
+        int32_t ki_mw_per_c_s;
+        /// @brief time between update() calls
+        uint32_t period_us;
+    };
+
+    /// @brief what a port asks for & what it gets
+    struct PortBudget {
+        /// @brief current drawn at any voltage, power of the port is voltage * current
+        uint16_t current_ma;
+        /// @brief wanted voltage, 0 while disconnected
+        uint16_t demand_mv;
+        /// @brief allowed voltage, 0 while disconnected
+        uint16_t grant_mv;
+    };
+
+    /// @brief Shares one power budget across ports in order of priority (order of add_port()).
+    /// Budget is derated from board temperature by a fixed-point PI loop, update() has to run at a fixed rate.
+    class PowerArbiter {
+    private:
+        PowerArbiterConfig config;
+        PortBudget ports[POWER_ARBITER_MAX_PORTS];
+        uint8_t port_count;
+
+        /// @brief integral part of the derating, mW << 16
+        int64_t integral_q16;
+        /// @brief integral gain of one period, mW << 16 per centi-degree
+        int64_t ki_step_q16;
+        /// @brief budget after derating
+        uint32_t budget_mw;
+        bool panic;
+
+        /// @brief run PI loop, sets budget_mw
+        void derate(int32_t centi);
+        /// @brief share budget_mw, higher priority ports first
+        /// @return true if any grant changed
+        bool allocate();
+
+    public:
+        PowerArbiter(const PowerArbiterConfig& config);
+
+        /// @brief register port, ports added first get power first
+        /// @param current_ma current the port draws at any voltage
+        /// @return port id, -1 when there's no space left
+        int add_port(uint16_t current_ma);
+
+        /// @brief set voltage a port wants, applied on the next update()
+        /// @param port id returned by add_port()
+        /// @param millivolts wanted voltage, 0 if nothing is connected
+        void set_demand(uint8_t port, uint16_t millivolts);
+
+        /// @brief one control period: derate budget from temperature & share it
+        /// @param centi hottest board temperature in centi-degrees
+        /// @return true if a grant or panic changed
+        bool update(int32_t centi);
+
+        /// @brief voltage a port may use, 0 while it's disconnected
+        uint16_t get_grant(uint8_t port) const { return ports[port].grant_mv; }
+
+        /// @brief port gets less than it wants because the budget is derated
+        bool is_limited(uint8_t port) const;
+
+        uint32_t get_budget() const { return budget_mw; }
+
+        /// @brief board is above panic temperature, every port is held at 5v
+        bool is_panic() const { return panic; }
+    };
+};
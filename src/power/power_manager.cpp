@@ -0,0 +1,108 @@
+#include "power_manager.h"
+
+#include "pico/multicore.h"
+#include "hardware/uart.h"
+#include "hardware/dma.h"
+
+#include "../logging/log.h"
+#include "../profiler/profiler.h"
+
+using namespace power;
+
+volatile bool PowerManager::wake_requested = false;
+
+PowerManager::PowerManager() {
+    state = PowerState::Active;
+    idle_since = 0;
+    i2c = nullptr;
+    i2c_baudrate = 0;
+}
+
+void PowerManager::set_i2c(i2c_inst_t* i2c, uint32_t baudrate) {
+    this->i2c = i2c;
+    i2c_baudrate = baudrate;
+}
+
+/// @brief FIFO is empty for a moment between two transfers of a frame, so its DMA channel counts too
+static bool is_sending(i2c_inst_t* i2c) {
+    i2c_hw_t* hw = i2c_get_hw(i2c);
+    for (uint channel = 0; channel < NUM_DMA_CHANNELS; channel++) {
+        if (dma_hw->ch[channel].write_addr == (uintptr_t)&hw->data_cmd && dma_channel_is_busy(channel)) { return true; }
+    }
+    return !(hw->status & I2C_IC_STATUS_TFE_BITS) || (hw->status & I2C_IC_STATUS_MST_ACTIVITY_BITS);
+}
+
+void PowerManager::begin(uint32_t wake_pin_mask) {
+    for (uint gpio = 0; gpio < 30; gpio++) {
+        if (!(wake_pin_mask & (1u << gpio))) { continue; }
+        gpio_init(gpio);
+        gpio_pull_up(gpio);
+        gpio_set_irq_enabled_with_callback(gpio, GPIO_IRQ_EDGE_FALL, true, gpio_wake);
+    }
+}
+
+void PowerManager::gpio_wake(uint, uint32_t) {
+    // interrupt itself ends the sleep, the flag tells update() to leave night mode
+    wake_requested = true;
+}
+
+void PowerManager::set_clock(uint32_t khz) {
+    // display core can't start a frame while it's parked, the one on the wire is let out before the i2c divider changes
+    bool park = multicore_lockout_victim_is_initialized(1);
+    if (park) { multicore_lockout_start_blocking(); }
+    bool drained = true;
+    if (i2c != nullptr) {
+        uint64_t until = time_us_64() + POWER_BUS_DRAIN_US;
+        while (drained && is_sending(i2c)) { drained = time_us_64() < until; }
+    }
+
+    bool changed = set_sys_clock_khz(khz, false);
+    if (changed) {
+        // clk_peri runs from USB PLL after the change, UART divider has to follow. i2c is clocked by clk_sys
+        uart_set_baudrate(uart0, PICO_DEFAULT_UART_BAUD_RATE);
+        if (i2c != nullptr) { i2c_set_baudrate(i2c, i2c_baudrate); }
+    }
+    if (park) { multicore_lockout_end_blocking(); }
+
+    if (!drained) { LOG_WARN("i2c bus was still busy, its frame may be cut\n"); }
+    if (!changed) {
+        LOG_WARN("clk_sys %lukHz is not possible\n", (unsigned long)khz);
+        return;
+    }
+    profiler::clock_changed();
+}
+
+bool PowerManager::update(const charging_protocols::PortState* ports, uint8_t count, uint64_t now) {
+    bool idle = !wake_requested;
+    wake_requested = false;
+    for (uint8_t port = 0; port < count; port++) {
+        if (ports[port].mode != ChargingModes::NotConnected) { idle = false; }
+    }
+
+    if (!idle) {
+        idle_since = 0;
+        if (state == PowerState::Active) { return false; }
+
+        set_clock(POWER_ACTIVE_CLOCK_KHZ);
+        state = PowerState::Active;
+        LOG_INFO("leaving night mode\n");
+        return true;
+    }
+
+    if (idle_since == 0) { idle_since = now; }
+    if (state == PowerState::Night || now - idle_since < POWER_IDLE_ENTER_US) { return false; }
+
+    set_clock(POWER_NIGHT_CLOCK_KHZ);
+    state = PowerState::Night;
+    LOG_INFO("entering night mode\n");
+    return true;
+}
+
+void PowerManager::idle_until(uint64_t until) {
+    uint64_t now = time_us_64();
+    if (until <= now + POWER_MIN_SLEEP_US) { return; }
+    if (until > now + POWER_MAX_SLEEP_US) { until = now + POWER_MAX_SLEEP_US; }
+
+    // any interrupt (wake pin, DMA, UART) ends it early, loop just checks the tasks again
+    best_effort_wfe_or_timeout(from_us_since_boot(until));
+}
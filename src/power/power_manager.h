@@ -0,0 +1,69 @@
+#pragma once
+
+#include <stdio.h>
+
+#include "pico/stdlib.h"
+#include "hardware/i2c.h"
+
+#include "../charging_protocols/port_state.h"
+
+// every port has to stay disconnected this long before night mode starts
+#define POWER_IDLE_ENTER_US (30 * 1000000)
+#define POWER_ACTIVE_CLOCK_KHZ 125000
+// lowest clock with PLL still running, switching back takes a PLL lock (<1ms)
+#define POWER_NIGHT_CLOCK_KHZ 48000
+// longest sleep, the loop has to get back to feed the watchdog
+#define POWER_MAX_SLEEP_US (100 * 1000)
+// shorter waits aren't worth a sleep
+#define POWER_MIN_SLEEP_US 20
+// longest wait for a frame on the i2c bus to finish before its divider changes, a full frame takes ~10ms at 1MHz
+#define POWER_BUS_DRAIN_US (30 * 1000)
+
+namespace power {
+    enum class PowerState : uint8_t {
+        Active,
+        Night       // ports disconnected, display off, slow clock & long task periods
+    };
+
+    /// @brief decides between active & night mode and puts the core to sleep between task releases
+    class PowerManager {
+    private:
+        PowerState state;
+        /// @brief since when all ports are disconnected, 0 while something is connected
+        uint64_t idle_since;
+
+        /// @brief controller whose divider follows clk_sys, nullptr if there's none
+        i2c_inst_t* i2c;
+        uint32_t i2c_baudrate;
+
+        /// @brief set from GPIO interrupt
+        static volatile bool wake_requested;
+        static void gpio_wake(uint gpio, uint32_t events);
+
+        void set_clock(uint32_t khz);
+
+    public:
+        PowerManager();
+
+        /// @brief enable wake-up pins, a falling edge on any of them leaves night mode
+        /// @param wake_pin_mask bit n is GPIO n, pins are pulled up
+        void begin(uint32_t wake_pin_mask);
+
+        /// @brief keep an i2c bus at its rate across clock changes, its divider is taken from clk_sys
+        /// @param i2c initialized controller, it may be driven by the other core
+        /// @param baudrate rate it was initialized with
+        void set_i2c(i2c_inst_t* i2c, uint32_t baudrate);
+
+        /// @brief decide state from port snapshots, clock is switched here. Display, task periods & PIO state machines
+        /// (e.g. QuickChargePort_alt::clock_changed()) are up to the caller
+        /// @param now current time in microseconds (time_us_64)
+        /// @return true if state changed
+        bool update(const charging_protocols::PortState* ports, uint8_t count, uint64_t now);
+
+        /// @brief sleep until given time or an interrupt, at most POWER_MAX_SLEEP_US. Returns right away if there's nothing to wait for
+        /// @param until time in microseconds (time_us_64), e.g. Scheduler::next_release()
+        void idle_until(uint64_t until);
+
+        PowerState get_state() const { return state; }
+    };
+};
@@ -0,0 +1,132 @@
+#include "profiler.h"
+
+#include "hardware/clocks.h"
+#include "hardware/structs/systick.h"
+
+// SysTick CSR: ENABLE | CLKSOURCE (processor clock), no interrupt
+#define SYSTICK_CSR_RUN 0x5
+#define SYSTICK_MAX     0x00FFFFFF
+
+using namespace profiler;
+
+#if PROFILER_ENABLED
+static StageStats stats[(uint8_t)Stage::COUNT];
+#else
+// nothing is recorded, get_stats() answers with one zeroed entry
+static const StageStats no_stats = {};
+#endif
+static uint32_t cycles_per_us = 125;
+
+static uint32_t boot_us[(uint8_t)BootPhase::COUNT];
+static uint32_t boot_reached = 0;
+
+static_assert((uint8_t)BootPhase::COUNT <= 32, "reached phases are a bit mask");
+static_assert(sizeof(BootPhase_string) / sizeof(BootPhase_string[0]) == (uint8_t)BootPhase::COUNT, "every boot phase needs a name");
+
+void profiler::init_core() {
+#if PROFILER_ENABLED
+    cycles_per_us = clock_get_hz(clk_sys) / 1000000;
+    systick_hw->csr = 0;
+    systick_hw->rvr = SYSTICK_MAX;
+    // any write clears the current value
+    systick_hw->cvr = 0;
+    systick_hw->csr = SYSTICK_CSR_RUN;
+#endif
+}
+
+void profiler::clock_changed() {
+#if PROFILER_ENABLED
+    cycles_per_us = clock_get_hz(clk_sys) / 1000000;
+#endif
+}
+
+Timestamp profiler::now() {
+    return { time_us_32(), systick_hw->cvr };
+}
+
+uint32_t profiler::elapsed_cycles(const Timestamp& start) {
+    uint32_t ticks = systick_hw->cvr;
+    uint32_t us = time_us_32() - start.us;
+
+    // SysTick counts down and wraps every 2^24 cycles
+    if (us < PROFILER_SYSTICK_MAX_US) {
+        return (start.ticks - ticks) & SYSTICK_MAX;
+    }
+    if (us > UINT32_MAX / cycles_per_us) { return UINT32_MAX; }
+    return us * cycles_per_us;
+}
+
+void profiler::record(Stage stage, uint32_t cycles) {
+#if PROFILER_ENABLED
+    StageStats& s = stats[(uint8_t)stage];
+
+    if (s.count == 0 || cycles < s.min_cycles) { s.min_cycles = cycles; }
+    if (cycles > s.max_cycles) { s.max_cycles = cycles; }
+    s.total_cycles += cycles;
+    s.count++;
+
+    uint8_t bucket = cycles == 0 ? 0 : 31 - __builtin_clz(cycles);
+    s.histogram[bucket]++;
+#endif
+}
+
+const StageStats& profiler::get_stats(Stage stage) {
+#if PROFILER_ENABLED
+    return stats[(uint8_t)stage];
+#else
+    return no_stats;
+#endif
+}
+
+void profiler::dump() {
+#if PROFILER_ENABLED
+    printf("profile, clk_sys %luMHz\n", (unsigned long)cycles_per_us);
+    for (uint8_t id = 0; id < (uint8_t)Stage::COUNT; id++) {
+        const StageStats& s = stats[id];
+        if (s.count == 0) { continue; }
+
+        uint32_t mean = s.total_cycles / s.count;
+        printf("stage %-8s n: %lu min: %lu max: %lu mean: %lu cycles (mean %luus)\n",
+            Stage_string[id], (unsigned long)s.count,
+            (unsigned long)s.min_cycles, (unsigned long)s.max_cycles, (unsigned long)mean,
+            (unsigned long)(mean / cycles_per_us));
+
+        // only buckets that were hit, as 2^n: count
+        printf("    ");
+        for (uint8_t bucket = 0; bucket < PROFILER_BUCKETS; bucket++) {
+            if (s.histogram[bucket] == 0) { continue; }
+            printf(" 2^%u: %lu", bucket, (unsigned long)s.histogram[bucket]);
+        }
+        printf("\n");
+    }
+#else
+    printf("profiler is disabled in this build\n");
+#endif
+}
+
+void profiler::reset() {
+#if PROFILER_ENABLED
+    for (StageStats& s : stats) {
+        s = {};
+    }
+#endif
+}
+
+void profiler::boot_mark(BootPhase phase) {
+    uint32_t bit = 1u << (uint8_t)phase;
+    if (boot_reached & bit) { return; }
+
+    boot_us[(uint8_t)phase] = time_us_32();
+    boot_reached |= bit;
+}
+
+void profiler::boot_dump() {
+    printf("boot phases, us since reset:");
+    uint32_t previous = 0;
+    for (uint8_t id = 0; id < (uint8_t)BootPhase::COUNT; id++) {
+        if (!(boot_reached & (1u << id))) { continue; }
+        printf(" %s %lu (+%lu)", BootPhase_string[id], (unsigned long)boot_us[id], (unsigned long)(boot_us[id] - previous));
+        previous = boot_us[id];
+    }
+    printf("\n");
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "pico/stdlib.h"
+
+#include "../scheduler/breadcrumb.h"
+
+// probes only leave watchdog breadcrumbs when 0
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED 1
+#endif
+
+// histogram bucket n counts runs that took [2^n, 2^(n+1)) cycles
+#define PROFILER_BUCKETS 32
+// SysTick is 24 bits, longer probes are measured with the 1MHz timer instead
+#define PROFILER_SYSTICK_MAX_US 100000
+
+/// Scoped probes around main loop stages. Durations are measured in clk_sys cycles with the SysTick
+/// of the core the probe runs on, every stage keeps min/max/mean and a log2 histogram in fixed RAM.
+/// A stage has to be probed from one core only, the dump reads statistics without locking.
+namespace profiler {
+    /// @brief profiled stages, add new ones before COUNT
+    enum class Stage : uint8_t {
+        QC,         // QC handshakes & mode changes, core 0
+        SENSORS,    // thermistor & chip temperature, core 0
+        DISPLAY,    // drawing of display commands, core 1
+        FLUSH,      // starting a frame transfer, core 1
+        WATCHDOG,   // check-in & watchdog update, core 0
+        LOG,        // log drain to UART, core 0
+        FLASH,      // flash log erase & program, core 0
+        USB,        // telemetry frames to USB CDC, core 0
+        COUNT
+    };
+
+    static const char* Stage_string[] = {
+        "qc",
+        "sensors",
+        "display",
+        "flush",
+        "watchdog",
+        "log",
+        "flash",
+        "usb"
+    };
+
+    /// @brief start-up steps in the order main() reaches them, add new ones before COUNT
+    enum class BootPhase : uint8_t {
+        STDIO,      // UART, USB & binary log
+        PORTS,      // charging ports started at their safe limit, first charging decision
+        FLASH_LOG,  // end of the flash log found
+        SENSORS,    // thermistor & battery gauge
+        TASKS,      // tasks registered, watchdog running
+        CHARGING,   // first run of the charging task finished
+        DISPLAY,    // core 1 launched, it initializes the panel
+        COUNT
+    };
+
+    static const char* BootPhase_string[] = {
+        "stdio",
+        "ports",
+        "flash log",
+        "sensors",
+        "tasks",
+        "charging",
+        "display"
+    };
+
+    struct StageStats {
+        uint32_t count;
+        uint32_t min_cycles;
+        uint32_t max_cycles;
+        uint64_t total_cycles;
+        uint32_t histogram[PROFILER_BUCKETS];
+    };
+
+    /// @brief start point of a measurement
+    struct Timestamp {
+        uint32_t us;
+        uint32_t ticks;
+    };
+
+    /// @brief start SysTick as a free running counter, has to be called on every core that runs probes
+    void init_core();
+
+    /// @brief pick up a new clk_sys frequency, SysTick keeps running
+    void clock_changed();
+
+    /// @brief take start point of a measurement
+    Timestamp now();
+
+    /// @brief cycles since start point
+    uint32_t elapsed_cycles(const Timestamp& start);
+
+    /// @brief add one measurement to stage statistics
+    void record(Stage stage, uint32_t cycles);
+
+    /// @brief statistics of a stage, all zero when profiler is disabled
+    const StageStats& get_stats(Stage stage);
+
+    /// @brief print statistics of all stages that ran
+    void dump();
+
+    /// @brief forget all measurements
+    void reset();
+
+    /// @brief note time since reset at which a boot phase ended, later calls for the same phase are ignored.
+    /// Boot phases are kept in every build, the profiler switch doesn't affect them
+    void boot_mark(BootPhase phase);
+
+    /// @brief print end of every boot phase reached so far
+    void boot_dump();
+
+    /// @brief stage stays in a watchdog scratch register until the end of the scope, see scheduler/breadcrumb.h
+    class StageBreadcrumb {
+    public:
+        StageBreadcrumb(Stage stage) { scheduler::leave_stage((uint8_t)stage); }
+        ~StageBreadcrumb() { scheduler::leave_stage(BREADCRUMB_NONE); }
+    };
+
+    /// @brief measures from construction to end of the scope
+    class ScopedProbe {
+    private:
+        StageBreadcrumb breadcrumb;
+        Stage stage;
+        Timestamp start;
+
+    public:
+        ScopedProbe(Stage stage) : breadcrumb(stage), stage(stage), start(now()) {}
+        ~ScopedProbe() { record(stage, elapsed_cycles(start)); }
+    };
+}
+
+#define PROFILER_CONCAT_INNER(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_INNER(a, b)
+
+#if PROFILER_ENABLED
+// measure rest of the enclosing scope, e.g. PROFILE_SCOPE(profiler::Stage::QC);
+#define PROFILE_SCOPE(stage) profiler::ScopedProbe PROFILER_CONCAT(profile_probe_, __LINE__)(stage)
+#else
+#define PROFILE_SCOPE(stage) profiler::StageBreadcrumb PROFILER_CONCAT(profile_breadcrumb_, __LINE__)(stage)
+#endif
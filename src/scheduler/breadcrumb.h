@@ -0,0 +1,39 @@
+#pragma once
+
+#include "pico/stdlib.h"
+#include "hardware/structs/watchdog.h"
+
+// watchdog scratch 0-3 are free (pico-sdk uses 4-7), they survive a watchdog reset but not power-on
+#define BREADCRUMB_TASK_SCRATCH     0
+#define BREADCRUMB_LATE_SCRATCH     1
+// one register per core, so neither has to lock
+#define BREADCRUMB_STAGE_SCRATCH    2
+// upper half tells a breadcrumb from what's left after power-on
+#define BREADCRUMB_MAGIC            0xB5C00000
+#define BREADCRUMB_MAGIC_MASK       0xFFFF0000
+#define BREADCRUMB_NONE             0xFF
+
+namespace scheduler {
+    /// @brief what ran when the watchdog fired, each field is BREADCRUMB_NONE if nothing was marked
+    struct Breadcrumb {
+        /// @brief task running on core 0
+        uint8_t task;
+        /// @brief first task that missed its check-in, it's why the watchdog wasn't fed
+        uint8_t late_task;
+        /// @brief profiler::Stage running on core 0 & core 1
+        uint8_t stage[2];
+    };
+
+    /// @brief single register write, cheap enough for every task run & probe
+    static inline void leave_breadcrumb(uint8_t scratch, uint8_t value) {
+        watchdog_hw->scratch[scratch] = BREADCRUMB_MAGIC | value;
+    }
+
+    static inline void leave_stage(uint8_t stage) {
+        leave_breadcrumb(BREADCRUMB_STAGE_SCRATCH + get_core_num(), stage);
+    }
+
+    /// @brief read breadcrumbs left before the reset and clear them, call before anything leaves new ones
+    /// @return false if there are none, e.g. after power-on
+    bool take_breadcrumb(Breadcrumb& out);
+};
@@ -0,0 +1,153 @@
+#include "scheduler.h"
+#include "breadcrumb.h"
+
+#include "../logging/log.h"
+
+#include "hardware/watchdog.h"
+
+using namespace scheduler;
+
+Scheduler::Scheduler() {
+    task_count = 0;
+}
+
+int Scheduler::add(const char* name, TaskFunction function, void* context, uint32_t period_us) {
+    if (task_count >= SCHEDULER_MAX_TASKS) {
+        LOG_ERROR("scheduler is full, task %s not added\n", name);
+        return -1;
+    }
+
+    uint64_t now = time_us_64();
+    Task& task = tasks[task_count];
+    task.name = name;
+    task.function = function;
+    task.context = context;
+    task.period_us = period_us;
+    task.slack_us = 0;
+    task.next_release = now;
+    task.last_finish = now;
+    task.stats = {};
+
+    return task_count++;
+}
+
+void Scheduler::set_period(int id, uint32_t period_us) {
+    if (id < 0 || id >= task_count) { return; }
+
+    Task& task = tasks[id];
+    task.period_us = period_us;
+    // don't wait out the rest of a long period
+    uint64_t release = task.last_finish + period_us;
+    if (release < task.next_release) { task.next_release = release; }
+}
+
+void Scheduler::set_slack(int id, uint32_t slack_us) {
+    if (id < 0 || id >= task_count) { return; }
+    tasks[id].slack_us = slack_us;
+}
+
+void Scheduler::run_pending(uint64_t now) {
+    for (uint8_t id = 0; id < task_count; id++) {
+        Task& task = tasks[id];
+        if (now < task.next_release) { continue; }
+
+        uint64_t start = time_us_64();
+        uint32_t jitter = start - task.next_release;
+        if (jitter > task.stats.max_jitter_us) { task.stats.max_jitter_us = jitter; }
+        task.stats.last_jitter_us = jitter;
+
+        leave_breadcrumb(BREADCRUMB_TASK_SCRATCH, id);
+        task.function(task.context);
+        leave_breadcrumb(BREADCRUMB_TASK_SCRATCH, BREADCRUMB_NONE);
+
+        uint64_t finish = time_us_64();
+        uint32_t exec = finish - start;
+        if (exec > task.stats.max_exec_us) { task.stats.max_exec_us = exec; }
+        task.stats.last_exec_us = exec;
+
+        task.stats.runs++;
+        task.last_finish = finish;
+
+        uint64_t deadline = task.next_release + task.period_us;
+        if (finish > deadline) { task.stats.overruns++; }
+
+        // keep fixed rate, releases that already passed are dropped
+        task.next_release = deadline;
+        if (task.next_release <= finish) {
+            uint64_t behind = (finish - task.next_release) / task.period_us + 1;
+            task.stats.skipped += behind;
+            task.next_release += behind * task.period_us;
+        }
+
+        // higher priority tasks may be due again
+        return;
+    }
+}
+
+uint64_t Scheduler::next_release() const {
+    uint64_t next = UINT64_MAX;
+    for (uint8_t id = 0; id < task_count; id++) {
+        if (tasks[id].next_release < next) { next = tasks[id].next_release; }
+    }
+    return next;
+}
+
+uint32_t Scheduler::idle_window(uint64_t now) const {
+    uint64_t window = UINT32_MAX;
+    for (uint8_t id = 0; id < task_count; id++) {
+        uint64_t latest = tasks[id].next_release + tasks[id].slack_us;
+        if (latest <= now) { return 0; }
+        if (latest - now < window) { window = latest - now; }
+    }
+    return window;
+}
+
+int Scheduler::late_task(uint64_t now) const {
+    for (uint8_t id = 0; id < task_count; id++) {
+        const Task& task = tasks[id];
+        if (now > task.last_finish + 2 * (uint64_t)task.period_us) { return id; }
+    }
+    return -1;
+}
+
+bool Scheduler::all_checked_in(uint64_t now) const {
+    return late_task(now) < 0;
+}
+
+bool Scheduler::feed_watchdog(uint64_t now) {
+    int late = late_task(now);
+    leave_breadcrumb(BREADCRUMB_LATE_SCRATCH, late < 0 ? BREADCRUMB_NONE : late);
+    if (late >= 0) { return false; }
+
+    watchdog_update();
+    return true;
+}
+
+bool scheduler::take_breadcrumb(Breadcrumb& out) {
+    const uint8_t scratch[] = { BREADCRUMB_TASK_SCRATCH, BREADCRUMB_LATE_SCRATCH, BREADCRUMB_STAGE_SCRATCH, BREADCRUMB_STAGE_SCRATCH + 1 };
+    uint8_t values[4];
+    bool found = false;
+
+    for (uint8_t i = 0; i < 4; i++) {
+        uint32_t raw = watchdog_hw->scratch[scratch[i]];
+        bool valid = (raw & BREADCRUMB_MAGIC_MASK) == BREADCRUMB_MAGIC;
+        values[i] = valid ? raw & 0xFF : BREADCRUMB_NONE;
+        found |= valid;
+        watchdog_hw->scratch[scratch[i]] = 0;
+    }
+
+    out = { values[0], values[1], { values[2], values[3] } };
+    return found;
+}
+
+void Scheduler::report() {
+    for (uint8_t id = 0; id < task_count; id++) {
+        Task& task = tasks[id];
+        printf("task %-8s runs: %lu overruns: %lu skipped: %lu max jitter: %luus max exec: %luus\n",
+            task.name,
+            (unsigned long)task.stats.runs, (unsigned long)task.stats.overruns, (unsigned long)task.stats.skipped,
+            (unsigned long)task.stats.max_jitter_us, (unsigned long)task.stats.max_exec_us);
+        task.stats.max_jitter_us = 0;
+        task.stats.max_exec_us = 0;
+    }
+}
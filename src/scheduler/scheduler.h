@@ -0,0 +1,103 @@
+#pragma once
+
+#include <stdio.h>
+
+#include "pico/stdlib.h"
+
+#define SCHEDULER_MAX_TASKS 10
+
+namespace scheduler {
+    /// @brief periodic job run by Scheduler
+    typedef void (*TaskFunction)(void* context);
+
+    /// @brief timing statistics of a task, all times in microseconds
+    struct TaskStats {
+        /// @brief number of finished runs
+        uint32_t runs;
+        /// @brief runs that finished after their deadline (end of own period)
+        uint32_t overruns;
+        /// @brief releases that were skipped because task was late by more than a period
+        uint32_t skipped;
+        /// @brief worst delay between release and start of a run
+        uint32_t max_jitter_us;
+        /// @brief worst execution time of a run
+        uint32_t max_exec_us;
+        /// @brief delay & execution time of the newest run
+        uint32_t last_jitter_us;
+        uint32_t last_exec_us;
+    };
+
+    struct Task {
+        const char* name;
+        TaskFunction function;
+        void* context;
+        uint32_t period_us;
+        /// @brief how late a run may start without breaking what the task controls
+        uint32_t slack_us;
+        /// @brief time at which next run is due
+        uint64_t next_release;
+        /// @brief time at which last run finished
+        uint64_t last_finish;
+        TaskStats stats;
+    };
+
+    /// @brief cooperative fixed-rate scheduler, tasks are run to completion in order of registration (first is most important)
+    class Scheduler {
+    private:
+        Task tasks[SCHEDULER_MAX_TASKS];
+        uint8_t task_count;
+
+        /// @brief first task that missed its check-in, -1 if there's none
+        int late_task(uint64_t now) const;
+
+    public:
+        Scheduler();
+
+        /// @brief register periodic task
+        /// @param name short name used in reports
+        /// @param function task body, must not block
+        /// @param context passed to function on every run
+        /// @param period_us time between releases in microseconds
+        /// @return task id, -1 when there's no space left
+        int add(const char* name, TaskFunction function, void* context, uint32_t period_us);
+
+        /// @brief change period of a task, a shorter one takes effect right away, a longer one after the next run
+        /// @param id task id returned by add()
+        /// @param period_us time between releases in microseconds
+        void set_period(int id, uint32_t period_us);
+
+        /// @brief set how late a task may start, 0 (default) if it has to run on time
+        /// @param id task id returned by add()
+        /// @param slack_us allowed delay in microseconds
+        void set_slack(int id, uint32_t slack_us);
+
+        /// @brief run the most important task that is due, call it in a loop.
+        /// Only one task is run per call so higher priority tasks are checked again before the next one.
+        /// @param now current time in microseconds (time_us_64)
+        void run_pending(uint64_t now);
+
+        /// @brief earliest time at which some task is due
+        uint64_t next_release() const;
+
+        /// @brief how long the caller may block before some task misses its slack, e.g. for a flash write
+        /// @param now current time in microseconds (time_us_64)
+        uint32_t idle_window(uint64_t now) const;
+
+        /// @brief check whether every task finished a run recently enough, i.e. no more than one release missed
+        bool all_checked_in(uint64_t now) const;
+
+        /// @brief update the watchdog only if all tasks checked in on time
+        /// @return true if watchdog was updated
+        bool feed_watchdog(uint64_t now);
+
+        const TaskStats& get_stats(uint8_t id) const { return tasks[id].stats; }
+
+        uint8_t get_task_count() const { return task_count; }
+
+        /// @brief name given to add(), "-" for an unknown id
+        const char* get_name(uint8_t id) const { return id < task_count ? tasks[id].name : "-"; }
+
+        /// @brief print statistics of all tasks and reset worst-case values
+        void report();
+    };
+};
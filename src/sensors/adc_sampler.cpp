@@ -0,0 +1,129 @@
+#include "adc_sampler.h"
+
+using namespace sensors;
+
+const AdcSampler* AdcSampler::owner = nullptr;
+
+AdcSampler::AdcSampler(uint8_t input_mask, uint32_t sample_rate_hz) {
+    this->input_mask = input_mask & ((1 << ADC_SAMPLER_MAX_CHANNELS) - 1);
+
+    // round robin goes through inputs in ascending order
+    channels = 0;
+    for (uint8_t input = 0; input < ADC_SAMPLER_MAX_CHANNELS; input++) {
+        slot_of[input] = (this->input_mask >> input) & 1 ? channels++ : -1;
+    }
+    block_length = channels * ADC_SAMPLER_DEPTH;
+    restart_address = buffer;
+
+    for (uint16_t& sample : buffer) { sample = 0; }
+
+    this->sample_rate_hz = sample_rate_hz;
+    dma_claimed = false;
+    running = false;
+    start_us = 0;
+}
+
+void AdcSampler::start() {
+    if (channels == 0) { return; }
+
+    // hardware is set up here, adc_init() resets the ADC
+    if (!dma_claimed) {
+        data_channel = dma_claim_unused_channel(true);
+        control_channel = dma_claim_unused_channel(true);
+        dma_claimed = true;
+    }
+
+    uint32_t total_rate = sample_rate_hz * channels;
+    if (total_rate > ADC_MAX_SAMPLE_RATE_HZ) { total_rate = ADC_MAX_SAMPLE_RATE_HZ; }
+    if (total_rate == 0) { total_rate = 1; }
+    // sample period is (1 + div) ADC clock cycles
+    adc_set_clkdiv((float)ADC_CLOCK_HZ / total_rate - 1);
+
+    for (uint8_t input = 0; input < ADC_TEMPERATURE_INPUT; input++) {
+        if (slot_of[input] >= 0) { adc_gpio_init(26 + input); }
+    }
+    if (slot_of[ADC_TEMPERATURE_INPUT] >= 0) { adc_set_temp_sensor_enabled(true); }
+
+    // first conversion is the lowest input, so frames start at slot 0
+    for (uint8_t input = 0; input < ADC_SAMPLER_MAX_CHANNELS; input++) {
+        if (slot_of[input] == 0) { adc_select_input(input); }
+    }
+    adc_set_round_robin(input_mask);
+    adc_fifo_setup(true, true, 1, false, false);
+    adc_fifo_drain();
+
+    // data channel: ADC FIFO -> buffer, paced by ADC, hands over to control channel when buffer is full
+    dma_channel_config data_config = dma_channel_get_default_config(data_channel);
+    channel_config_set_transfer_data_size(&data_config, DMA_SIZE_16);
+    channel_config_set_read_increment(&data_config, false);
+    channel_config_set_write_increment(&data_config, true);
+    channel_config_set_dreq(&data_config, DREQ_ADC);
+    channel_config_set_chain_to(&data_config, control_channel);
+    dma_channel_configure(data_channel, &data_config, buffer, &adc_hw->fifo, block_length, false);
+
+    // control channel: rewrites data channel write address, which triggers it again
+    dma_channel_config control_config = dma_channel_get_default_config(control_channel);
+    channel_config_set_transfer_data_size(&control_config, DMA_SIZE_32);
+    channel_config_set_read_increment(&control_config, false);
+    channel_config_set_write_increment(&control_config, false);
+    dma_channel_configure(control_channel, &control_config, &dma_hw->ch[data_channel].al2_write_addr_trig,
+        &restart_address, 1, false);
+
+    dma_channel_start(data_channel);
+    adc_run(true);
+    start_us = time_us_64();
+    running = true;
+    owner = this;
+}
+
+void AdcSampler::stop() {
+    running = false;
+    if (owner == this) { owner = nullptr; }
+    adc_run(false);
+    adc_set_round_robin(0);
+    // control channel first, so it can't restart data channel
+    dma_channel_abort(control_channel);
+    dma_channel_abort(data_channel);
+    adc_fifo_setup(false, false, 0, false, false);
+    adc_fifo_drain();
+}
+
+bool AdcSampler::has_samples(uint16_t count) const {
+    return running && (time_us_64() - start_us) * sample_rate_hz >= (uint64_t)count * 1000000;
+}
+
+uint32_t AdcSampler::newest_frame() const {
+    uintptr_t written = (dma_hw->ch[data_channel].write_addr - (uintptr_t)buffer) / sizeof(uint16_t);
+    uint32_t frames = written / channels;
+    // nothing complete in this pass yet, newest frame is the last one of the previous pass
+    if (frames == 0 || frames > ADC_SAMPLER_DEPTH) { return ADC_SAMPLER_DEPTH - 1; }
+    return frames - 1;
+}
+
+uint16_t AdcSampler::latest(uint8_t input) const {
+    if (!is_sampled(input)) { return 0; }
+
+    return buffer[newest_frame() * channels + slot_of[input]];
+}
+
+uint16_t AdcSampler::window(uint8_t input, uint16_t* out, uint16_t count) const {
+    if (!is_sampled(input)) { return 0; }
+    if (count > ADC_SAMPLER_DEPTH - 2) { count = ADC_SAMPLER_DEPTH - 2; }
+
+    uint32_t frame = newest_frame();
+    for (uint16_t i = 0; i < count; i++) {
+        out[i] = buffer[frame * channels + slot_of[input]];
+        frame = frame == 0 ? ADC_SAMPLER_DEPTH - 1 : frame - 1;
+    }
+    return count;
+}
+
+uint16_t AdcSampler::average(uint8_t input, uint16_t count) const {
+    uint16_t samples[ADC_SAMPLER_DEPTH];
+    count = window(input, samples, count);
+    if (count == 0) { return 0; }
+
+    uint32_t sum = 0;
+    for (uint16_t i = 0; i < count; i++) { sum += samples[i]; }
+    return sum / count;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <stdio.h>
+
+#include "pico/stdlib.h"
+#include "hardware/adc.h"
+#include "hardware/dma.h"
+
+#define ADC_SAMPLER_MAX_CHANNELS    5
+// samples kept per channel
+#define ADC_SAMPLER_DEPTH           32
+#define ADC_TEMPERATURE_INPUT       4
+// ADC runs from 48MHz clock, one conversion takes 96 cycles
+#define ADC_CLOCK_HZ                48000000
+#define ADC_MAX_SAMPLE_RATE_HZ      500000
+
+namespace sensors {
+    /// @brief background sampler, ADC free-runs in round-robin mode and DMA moves its FIFO into
+    /// an interleaved ring of frames (one sample per enabled input). Readers never wait for a conversion.
+    class AdcSampler {
+    private:
+        /// @brief enabled inputs, bit n is ADC input n
+        uint8_t input_mask;
+        uint8_t channels;
+        /// @brief position of an input inside a frame, -1 if input isn't sampled
+        int8_t slot_of[ADC_SAMPLER_MAX_CHANNELS];
+
+        /// @brief interleaved frames, DMA writes them in a loop
+        uint16_t buffer[ADC_SAMPLER_MAX_CHANNELS * ADC_SAMPLER_DEPTH];
+
+        /// @brief samples in one pass over the buffer
+        uint32_t block_length;
+
+        /// @brief DMA channel moving the ADC FIFO to buffer
+        uint data_channel;
+        /// @brief DMA channel restarting data_channel at the beginning of buffer
+        uint control_channel;
+        /// @brief read by control_channel, holds address of buffer
+        uint16_t* restart_address;
+        bool dma_claimed;
+
+        /// @brief samples per second of every channel
+        uint32_t sample_rate_hz;
+        /// @brief buffer holds zeros until DMA got around to it
+        bool running;
+        uint64_t start_us;
+
+        /// @brief index of the newest complete frame
+        uint32_t newest_frame() const;
+
+        /// @brief sampler that runs the ADC, there's only one converter
+        static const AdcSampler* owner;
+
+    public:
+        /// @param input_mask inputs to sample, bit n is ADC input n (0-3 are GPIO 26-29, 4 is temperature sensor)
+        /// @param sample_rate_hz samples per second of every channel
+        AdcSampler(uint8_t input_mask, uint32_t sample_rate_hz);
+
+        /// @brief configure ADC & DMA and start sampling, adc_init() has to be called before
+        void start();
+
+        /// @brief stop ADC and DMA
+        void stop();
+
+        /// @brief newest sample of an input
+        /// @return raw 12 bit value, 0 if input isn't sampled
+        uint16_t latest(uint8_t input) const;
+
+        /// @brief copy newest samples of an input, newest first
+        /// @param out destination, at least count elements
+        /// @param count samples wanted, limited to ADC_SAMPLER_DEPTH - 2 so DMA can't overwrite them while copying
+        /// @return number of samples copied
+        uint16_t window(uint8_t input, uint16_t* out, uint16_t count) const;
+
+        /// @brief mean of newest samples of an input
+        uint16_t average(uint8_t input, uint16_t count) const;
+
+        /// @brief at least count samples of every input were taken since start(), older ones are still zeros
+        bool has_samples(uint16_t count) const;
+
+        bool is_sampled(uint8_t input) const { return input < ADC_SAMPLER_MAX_CHANNELS && slot_of[input] >= 0; }
+
+        /// @brief a sampler is running, adc_select_input() & adc_read() would break the channel order of its ring
+        static bool is_adc_owned() { return owner != nullptr; }
+    };
+};
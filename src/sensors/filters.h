@@ -0,0 +1,152 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+/// Heap-free filters for sensor readings, capacity is fixed at compile time.
+/// All of them keep their whole state inside the object.
+namespace sensors {
+    /// @brief moving average over last N values, running sum makes every update O(1)
+    /// @tparam T sample type
+    /// @tparam N window length
+    /// @tparam Sum accumulator type, has to hold N * max(T)
+    template <typename T, uint16_t N, typename Sum = int32_t>
+    class MovingAverage {
+        static_assert(N > 0, "window can't be empty");
+
+    private:
+        T window[N];
+        Sum sum;
+        /// @brief slot that is overwritten next
+        uint16_t next;
+        /// @brief values in window, reaches N after warm-up
+        uint16_t count;
+
+    public:
+        MovingAverage() { reset(); }
+
+        void reset() {
+            memset(window, 0, sizeof(window));
+            sum = 0;
+            next = 0;
+            count = 0;
+        }
+
+        /// @brief add value, oldest one drops out once window is full
+        /// @return average of values in window
+        T update(T value) {
+            if (count == N) {
+                sum -= window[next];
+            }
+            else {
+                count++;
+            }
+            window[next] = value;
+            sum += value;
+            next = next + 1 == N ? 0 : next + 1;
+            return get();
+        }
+
+        /// @return average of values in window, 0 if empty
+        T get() const { return count == 0 ? 0 : sum / count; }
+
+        bool is_full() const { return count == N; }
+    };
+
+    /// @brief exponential moving average with alpha = 1 / 2^Shift, integer only
+    /// @tparam Shift larger is smoother, state keeps Shift fractional bits
+    template <uint8_t Shift>
+    class ExponentialAverage {
+        static_assert(Shift < 16, "shift too large for 32 bit state");
+
+    private:
+        /// @brief average scaled by 2^Shift
+        int32_t scaled;
+        bool primed;
+
+    public:
+        ExponentialAverage() { reset(); }
+
+        void reset() {
+            scaled = 0;
+            primed = false;
+        }
+
+        /// @brief add value, first value is taken as is
+        /// @return new average
+        int32_t update(int32_t value) {
+            if (!primed) {
+                scaled = value * (1 << Shift);
+                primed = true;
+            }
+            else {
+                scaled += value - (scaled >> Shift);
+            }
+            return get();
+        }
+
+        int32_t get() const { return scaled >> Shift; }
+    };
+
+    /// @brief median of last N values, rejects spikes shorter than N / 2 samples.
+    /// Keeps a sorted copy of the window: positions are found by binary search, elements shifted with memmove.
+    /// @tparam T sample type
+    /// @tparam N window length, odd
+    template <typename T, uint16_t N>
+    class MedianFilter {
+        static_assert(N % 2 == 1, "median window has to be odd");
+
+    private:
+        /// @brief values in order of arrival
+        T window[N];
+        /// @brief same values sorted ascending
+        T sorted[N];
+        uint16_t next;
+        uint16_t count;
+
+        /// @brief first position in sorted whose value is not less than value
+        uint16_t lower_bound(T value) const {
+            uint16_t low = 0;
+            uint16_t high = count;
+            while (low < high) {
+                uint16_t mid = (low + high) / 2;
+                if (sorted[mid] < value) { low = mid + 1; }
+                else { high = mid; }
+            }
+            return low;
+        }
+
+    public:
+        MedianFilter() { reset(); }
+
+        void reset() {
+            next = 0;
+            count = 0;
+        }
+
+        /// @brief add value, oldest one drops out once window is full
+        /// @return median of values in window
+        T update(T value) {
+            if (count == N) {
+                // drop oldest value from sorted copy
+                uint16_t old = lower_bound(window[next]);
+                memmove(&sorted[old], &sorted[old + 1], (count - old - 1) * sizeof(T));
+                count--;
+            }
+
+            uint16_t pos = lower_bound(value);
+            memmove(&sorted[pos + 1], &sorted[pos], (count - pos) * sizeof(T));
+            sorted[pos] = value;
+            count++;
+
+            window[next] = value;
+            next = next + 1 == N ? 0 : next + 1;
+            return get();
+        }
+
+        /// @return median of values in window, 0 if empty
+        T get() const { return count == 0 ? 0 : sorted[count / 2]; }
+
+        bool is_full() const { return count == N; }
+    };
+}
@@ -0,0 +1,150 @@
+#include "fuel_gauge.h"
+
+#include <stdlib.h>
+
+#include "../logging/log.h"
+
+using namespace sensors;
+
+static_assert(ocv_percent(2500) == 0);
+static_assert(ocv_percent(3830) == 50);
+static_assert(ocv_percent(3850) == 55);
+static_assert(ocv_percent(4300) == 100);
+// whole gauge is kept next to the other tasks' state, no buffers of its own
+static_assert(sizeof(FuelGauge) <= 128, "fuel gauge state has grown");
+
+FuelGauge::FuelGauge(const AdcSampler* sampler, uint32_t sample_rate_hz, const FuelGaugeConfig& config) {
+    this->sampler = sampler;
+    this->sample_rate_hz = sample_rate_hz;
+    this->config = config;
+    capacity_mas = config.capacity_mah * 3600;
+
+    charge_mas = 0;
+    residue = 0;
+    current_ma = 0;
+    average_ma_scaled = 0;
+    pack_mv = 0;
+    charge_known = false;
+    last_update = 0;
+    rest_since = 0;
+    last_ocv = 0;
+    mux_voltage = false;
+    mux_settled = 0;
+}
+
+void FuelGauge::begin(uint64_t now) {
+    if (!sampler->is_sampled(config.current_adc) || !sampler->is_sampled(config.voltage_adc)) {
+        LOG_ERROR("fuel gauge adc %d/%d is not sampled\n", config.current_adc, config.voltage_adc);
+    }
+
+    last_update = now;
+    if (is_shared()) {
+        gpio_init(config.mux_pin);
+        gpio_set_dir(config.mux_pin, true);
+    }
+    set_mux(false, now);
+}
+
+void FuelGauge::set_mux(bool voltage, uint64_t now) {
+    mux_voltage = voltage;
+    if (!is_shared()) { return; }
+
+    gpio_put(config.mux_pin, voltage);
+    mux_settled = now + FUEL_GAUGE_MUX_SETTLE_US;
+}
+
+uint16_t FuelGauge::samples_in(uint64_t us) const {
+    uint64_t samples = us * sample_rate_hz / 1000000;
+    if (samples < 1) { return 1; }
+    if (samples > ADC_SAMPLER_DEPTH - 2) { return ADC_SAMPLER_DEPTH - 2; }
+    return samples;
+}
+
+int32_t FuelGauge::read_current(uint64_t window_us) const {
+    int32_t raw = sampler->average(config.current_adc, samples_in(window_us));
+    return (raw - config.current_zero_raw) * config.current_ua_per_count / 1000;
+}
+
+uint16_t FuelGauge::read_voltage(uint64_t window_us) const {
+    uint32_t raw = sampler->average(config.voltage_adc, samples_in(window_us));
+    return raw * config.voltage_uv_per_count / 1000;
+}
+
+void FuelGauge::correct(uint16_t millivolts) {
+    uint8_t percent = ocv_percent(millivolts / config.cells);
+    int32_t target = capacity_mas / 100 * percent;
+
+    if (!charge_known) {
+        charge_mas = target;
+        charge_known = true;
+        LOG_INFO("battery starts at %d%% (%umV)\n", percent, millivolts);
+        return;
+    }
+
+    // single reading isn't trusted over the counter, it only pulls it
+    charge_mas += (target - charge_mas) / (1 << FUEL_GAUGE_OCV_BLEND_SHIFT);
+    LOG_DEBUG("battery OCV %umV is %d%%, counter at %d%%\n", millivolts, percent, get_percentage());
+}
+
+void FuelGauge::update(uint64_t now) {
+    uint64_t elapsed = now - last_update;
+
+    // shared input only shows current once the mux settled on it, else the last current is kept
+    uint64_t window = elapsed;
+    if (is_shared()) {
+        uint64_t valid_from = last_update > mux_settled ? last_update : mux_settled;
+        window = mux_voltage || now <= valid_from ? 0 : now - valid_from;
+    }
+    if (window > 0) {
+        current_ma = read_current(window);
+    }
+    last_update = now;
+
+    // mA*us, whole mA*s go to the counter and the rest waits for the next update
+    int64_t used = (int64_t)current_ma * (int64_t)elapsed + residue;
+    charge_mas -= used / 1000000;
+    residue = used % 1000000;
+    if (charge_mas < 0) { charge_mas = 0; }
+    if (charge_mas > (int32_t)capacity_mas) { charge_mas = capacity_mas; }
+
+    average_ma_scaled += current_ma - (average_ma_scaled >> FUEL_GAUGE_AVERAGE_SHIFT);
+
+    if (abs(current_ma) > config.rest_current_ma) { rest_since = 0; }
+    else if (rest_since == 0) { rest_since = now; }
+    bool rested = rest_since != 0 && now - rest_since >= config.rest_time_us;
+    bool ocv_due = !charge_known || (rested && now - last_ocv >= FUEL_GAUGE_OCV_PERIOD_US);
+
+    if (!is_shared()) {
+        pack_mv = read_voltage(elapsed);
+        if (ocv_due) {
+            correct(pack_mv);
+            last_ocv = now;
+        }
+        return;
+    }
+
+    if (mux_voltage) {
+        if (now <= mux_settled) { return; }
+        pack_mv = read_voltage(now - mux_settled);
+        correct(pack_mv);
+        last_ocv = now;
+        set_mux(false, now);
+    }
+    else if (ocv_due) {
+        set_mux(true, now);
+    }
+}
+
+uint8_t FuelGauge::get_percentage() const {
+    if (!charge_known || capacity_mas < 100) { return 0; }
+    uint32_t percent = charge_mas / (capacity_mas / 100);
+    return percent < 100 ? percent : 100;
+}
+
+uint16_t FuelGauge::get_time_to_empty() const {
+    int32_t average_ma = average_ma_scaled >> FUEL_GAUGE_AVERAGE_SHIFT;
+    if (!charge_known || average_ma <= config.rest_current_ma) { return FUEL_GAUGE_UNKNOWN_TIME; }
+
+    uint32_t minutes = charge_mas / average_ma / 60;
+    return minutes < FUEL_GAUGE_UNKNOWN_TIME ? minutes : FUEL_GAUGE_UNKNOWN_TIME - 1;
+}
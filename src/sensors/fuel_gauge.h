@@ -0,0 +1,133 @@
+#pragma once
+
+#include <stdio.h>
+
+#include "pico/stdlib.h"
+
+#include "adc_sampler.h"
+
+// resting pack is compared against the OCV table at most this often
+#define FUEL_GAUGE_OCV_PERIOD_US (10 * 1000000)
+// counted charge moves 1/2^n of the way towards the OCV estimate on every correction
+#define FUEL_GAUGE_OCV_BLEND_SHIFT 3
+// current average for time-to-empty follows new readings with weight 1/2^n
+#define FUEL_GAUGE_AVERAGE_SHIFT 5
+// shared sense input needs this long to settle after the mux switched
+#define FUEL_GAUGE_MUX_SETTLE_US 2000
+// time-to-empty while the pack isn't discharging
+#define FUEL_GAUGE_UNKNOWN_TIME 0xFFFF
+
+namespace sensors {
+    /// @brief point of an open-circuit voltage curve
+    struct OcvPoint {
+        uint16_t millivolts;
+        uint8_t percent;
+    };
+
+    /// @brief resting voltage of one Li-ion cell against its state of charge, ascending
+    static constexpr OcvPoint LIION_OCV[] = {
+        { 3000, 0 }, { 3300, 2 }, { 3450, 5 }, { 3600, 12 }, { 3680, 20 }, { 3740, 30 }, { 3790, 40 },
+        { 3830, 50 }, { 3870, 60 }, { 3930, 70 }, { 4000, 80 }, { 4080, 90 }, { 4200, 100 }
+    };
+
+    /// @brief state of charge of a resting cell, linear between points of LIION_OCV
+    constexpr uint8_t ocv_percent(uint16_t cell_millivolts) {
+        const uint8_t last = sizeof(LIION_OCV) / sizeof(LIION_OCV[0]) - 1;
+        if (cell_millivolts <= LIION_OCV[0].millivolts) { return LIION_OCV[0].percent; }
+        if (cell_millivolts >= LIION_OCV[last].millivolts) { return LIION_OCV[last].percent; }
+
+        uint8_t i = 1;
+        while (LIION_OCV[i].millivolts < cell_millivolts) { i++; }
+        const OcvPoint& low = LIION_OCV[i - 1];
+        const OcvPoint& high = LIION_OCV[i];
+        return low.percent + (uint32_t)(cell_millivolts - low.millivolts) * (high.percent - low.percent)
+            / (high.millivolts - low.millivolts);
+    }
+
+    /// @brief battery & its sense circuit
+    struct FuelGaugeConfig {
+        uint16_t capacity_mah;
+        /// @brief cells in series, OCV table is per cell
+        uint8_t cells;
+        /// @brief ADC inputs of the current sense amplifier & pack voltage divider, may be the same input
+        uint8_t current_adc;
+        uint8_t voltage_adc;
+        /// @brief GPIO of the mux in front of a shared input, high selects pack voltage. Unused for separate inputs
+        uint8_t mux_pin;
+        /// @brief raw reading at 0A, sense amplifier is bidirectional
+        uint16_t current_zero_raw;
+        /// @brief current of one ADC count, positive is discharge
+        int32_t current_ua_per_count;
+        /// @brief pack voltage of one ADC count, divider included
+        uint32_t voltage_uv_per_count;
+        /// @brief pack is resting below this current, only then its voltage is close to OCV
+        uint16_t rest_current_ma;
+        /// @brief how long pack has to rest before OCV is trusted
+        uint32_t rest_time_us;
+    };
+
+    /// @brief Coulomb counter corrected by resting voltage. Sampling is done by AdcSampler's DMA,
+    /// update() only averages the samples taken since the last call. Integer math only.
+    class FuelGauge {
+    private:
+        const AdcSampler* sampler;
+        FuelGaugeConfig config;
+        uint32_t sample_rate_hz;
+        uint32_t capacity_mas;
+
+        /// @brief remaining charge in mA*s
+        int32_t charge_mas;
+        /// @brief counted charge below 1 mA*s, in mA*us
+        int32_t residue;
+
+        /// @brief current of the last update, positive is discharge
+        int32_t current_ma;
+        /// @brief average current << FUEL_GAUGE_AVERAGE_SHIFT
+        int32_t average_ma_scaled;
+        uint16_t pack_mv;
+        /// @brief charge is set from the first voltage reading
+        bool charge_known;
+
+        uint64_t last_update;
+        /// @brief start of the current rest, 0 while pack is loaded
+        uint64_t rest_since;
+        uint64_t last_ocv;
+
+        /// @brief shared input shows pack voltage
+        bool mux_voltage;
+        /// @brief samples of the shared input are valid from here
+        uint64_t mux_settled;
+
+        bool is_shared() const { return config.current_adc == config.voltage_adc; }
+        /// @brief samples the sampler took in given time, limited to what it keeps
+        uint16_t samples_in(uint64_t us) const;
+        int32_t read_current(uint64_t window_us) const;
+        uint16_t read_voltage(uint64_t window_us) const;
+        void set_mux(bool voltage, uint64_t now);
+        /// @brief move counted charge towards OCV estimate, or set it if it wasn't known
+        void correct(uint16_t millivolts);
+
+    public:
+        /// @param sampler running sampler that samples both ADC inputs
+        /// @param sample_rate_hz samples per second of every channel of the sampler
+        FuelGauge(const AdcSampler* sampler, uint32_t sample_rate_hz, const FuelGaugeConfig& config);
+
+        /// @brief set up the mux & take the first voltage reading as soon as it's possible
+        void begin(uint64_t now);
+
+        /// @brief integrate current since the last call, has to be called at least every
+        /// (ADC_SAMPLER_DEPTH - 2) sample periods so no sample is lost
+        /// @param now current time in microseconds (time_us_64)
+        void update(uint64_t now);
+
+        /// @brief state of charge 0-100, 0 until the first voltage reading
+        uint8_t get_percentage() const;
+
+        /// @brief minutes until empty at the average current, FUEL_GAUGE_UNKNOWN_TIME if it isn't discharging
+        uint16_t get_time_to_empty() const;
+
+        int32_t get_current() const { return current_ma; }
+
+        uint16_t get_voltage() const { return pack_mv; }
+    };
+};
@@ -1,47 +1,72 @@
 #include "thermistor.h"
 
+#include "../logging/log.h"
+
 
 using namespace sensors;
 
 Thermistor::Thermistor(uint8_t pin, uint8_t adc,
     double R0, double  R1,
-    double  beta) {
+    double  beta, Divider divider) {
     this->pin = pin;
     this->adc = adc;
     this->R0 = R0;
     this->R1 = R1;
     this->beta = beta;
-    this->samples = { 1,2,3,4,5,6,7,8,9,0 };
-    this->sum = 0;
+    this->divider = divider;
+    this->lookup = nullptr;
+    this->source = nullptr;
+}
 
+
+double Thermistor::get_average() {
+    return get_average_centi() / 100.;
 }
 
+int32_t Thermistor::get_average_centi() {
+    return average.update(spikes.update(get_centi()));
+}
 
-double Thermistor::get_average(int num_samples) {
-    samples.resize(num_samples);
-    samples.push_back(this->get());
-    std::rotate(samples.rbegin(), samples.rbegin() + 1, samples.rend());
+void Thermistor::set_lookup(int32_t (*lookup)(uint16_t raw)) {
+    this->lookup = lookup;
+}
 
-    printf("size: %d\n", samples.size());
-    for (double d : samples) {
-        sum += d;
-        printf("d: %.2f\n", d);
+void Thermistor::set_source(const AdcSampler* source) {
+    if (!source->is_sampled(adc)) {
+        LOG_ERROR("adc %d is not sampled, thermistor keeps blocking reads\n", adc);
+        return;
     }
-    sum /= num_samples;
-    printf("sum: %.2f\n", sum);
-    return sum;
+    this->source = source;
+}
+
+uint16_t Thermistor::read_raw() {
+    if (source != nullptr) {
+        return source->latest(adc);
+    }
+
+    // a single conversion would shift every later sample of a running sampler into the wrong channel
+    hard_assert(!AdcSampler::is_adc_owned());
+    adc_select_input(adc);
+    return adc_read();
 }
 
 double Thermistor::get() {
-    adc_select_input(0);
-    int raw = adc_read();
-    float voltage = raw * ADC_CONVERSION_FACTOR;
-    float resistance = R1 * voltage;
+    int raw = read_raw();
+    [[maybe_unused]] float voltage = raw * ADC_CONVERSION_FACTOR;
+    double resistance = thermistor_math::resistance(raw, R1, divider);
     // beta coefficient equation
     double T = 1. / ((1. / (25 + 273.15)) + (1. / beta) * log(resistance / R0));
     // conversion to celsius + correction
     T -= 273.15;
-    printf("resistance: %.2fOhm\n", resistance);
-    printf("voltage: %.2fV\n", voltage);
+    LOG_DEBUG("resistance: %.2fOhm\n", resistance);
+    LOG_DEBUG("voltage: %.2fV\n", voltage);
     return T;
+}
+
+int32_t Thermistor::get_centi() {
+    if (lookup == nullptr) {
+        return get() * 100;
+    }
+
+    return lookup(read_raw());
 }
\ No newline at end of file
@@ -1,13 +1,20 @@
 #pragma once
 
-#include <vector>
 #include <stdio.h>
-#include <algorithm>
 #include <math.h>
 
 #include "pico/stdlib.h"
 #include "hardware/adc.h"
 
+#include "thermistor_table.h"
+#include "adc_sampler.h"
+#include "filters.h"
+
+// readings averaged by get_average()
+#define THERMISTOR_AVERAGE_WINDOW 10
+// readings a spike has to outlast to get into the average
+#define THERMISTOR_MEDIAN_WINDOW 3
+
 
 // Stats for used 100kOhm K3950 thermsitors
 // R0 100000            // Nominal resistance at 25⁰C
@@ -18,7 +25,7 @@
 
 namespace sensors {
 
-#define ADC_CONVERSION_FACTOR (3.3f / (1 << 12)); // for 3.3v load in 12 bits
+#define ADC_CONVERSION_FACTOR (3.3f / (1 << 12)) // for 3.3v load in 12 bits
     /// thermistor object, only NTC are supported
     class Thermistor {
     private:
@@ -31,10 +38,20 @@ namespace sensors {
         /// @param R1 resistance of  
         /// @param beta the beta coefficient
         double R0, R1, beta;
-        std::vector<int> samples;
+        /// @brief divider topology
+        Divider divider;
+        /// @brief integer ADC code -> centi-degree mapping, e.g. ThermistorTable<...>::centi_celsius
+        int32_t (*lookup)(uint16_t raw);
+        /// @brief background sampler, if set ADC isn't touched on reads
+        const AdcSampler* source;
+        /// @brief spike rejection in front of the average, in centi-degrees
+        MedianFilter<int32_t, THERMISTOR_MEDIAN_WINDOW> spikes;
+        /// @brief average of last readings, in centi-degrees
+        MovingAverage<int32_t, THERMISTOR_AVERAGE_WINDOW> average;
 
-        /// @brief sum for averaging
-        double sum;
+        /// @brief newest raw ADC value, from sampler if there's one.
+        /// Converting without one is only allowed while no AdcSampler is running
+        uint16_t read_raw();
 
     public:
         /// @brief main constructor
@@ -43,17 +60,34 @@ namespace sensors {
         /// @param R0 base resistance of thermistor at T0 (25C)
         /// @param R1 resistance of  
         /// @param beta the beta coefficient
+        /// @param divider where the thermistor sits in the voltage divider
         Thermistor(uint8_t pin, uint8_t adc,
             double R0, double  R1,
-            double  beta);
+            double  beta, Divider divider = Divider::NTC_LOW);
+
+        /// @brief use integer table for get_centi(), it has to be built from the same parameters
+        /// @param lookup e.g. ThermistorTable<100000, 100000, 3950>::centi_celsius
+        void set_lookup(int32_t (*lookup)(uint16_t raw));
 
-        /// @brief get averaged temperature based on 10 last readings
-        /// @param num_samples number of samples for averaging
-        /// @return averaged temperature
-        double get_average(int num_samples);
+        /// @brief take readings from a running sampler instead of converting on every call
+        /// @param source sampler that samples this thermistor's adc input, required once any sampler is running
+        void set_source(const AdcSampler* source);
 
-        /// @brief get current temperature at thermistor
+        /// @brief take a reading and get averaged temperature based on 10 last readings, short spikes are dropped
+        /// @return averaged temperature in C
+        double get_average();
+
+        /// @brief same as get_average(), no floating point involved
+        /// @return averaged temperature in centi-degrees C
+        int32_t get_average_centi();
+
+        /// @brief get current temperature at thermistor with the beta equation, reference for get_centi()
         /// @return current temperature in C
         double get();
+
+        /// @brief get current temperature at thermistor from lookup table, no floating point involved.
+        /// Falls back to get() if no table was set.
+        /// @return current temperature in centi-degrees C
+        int32_t get_centi();
     };
 };
\ No newline at end of file
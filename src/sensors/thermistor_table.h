@@ -0,0 +1,128 @@
+#pragma once
+
+#include <stdint.h>
+
+// ADC codes per segment of the piecewise-linear table
+#define THERMISTOR_TABLE_STEP_BITS      4
+// accuracy the table has to keep against the beta equation, checked at compile time
+#define THERMISTOR_TABLE_MAX_ERROR_CENTI    25
+#define THERMISTOR_TABLE_MIN_CELSIUS    -40
+#define THERMISTOR_TABLE_MAX_CELSIUS    150
+
+namespace sensors {
+    /// @brief where the NTC sits in the voltage divider, the fixed resistor R1 is on the other side
+    enum class Divider {
+        NTC_LOW,    // R1 to supply, NTC to ground
+        NTC_HIGH    // NTC to supply, R1 to ground
+    };
+
+    namespace thermistor_math {
+        /// @brief natural logarithm usable at compile time
+        constexpr double ln(double x) {
+            // reduce to [1, 2)
+            int k = 0;
+            while (x >= 2.) { x /= 2.; k++; }
+            while (x < 1.) { x *= 2.; k--; }
+
+            // ln(x) = 2 * atanh(y), y < 1/3 so the series converges fast
+            double y = (x - 1.) / (x + 1.);
+            double y2 = y * y;
+            double term = y;
+            double sum = 0.;
+            for (int n = 1; n < 40; n += 2) {
+                sum += term / n;
+                term *= y2;
+            }
+            return 2. * sum + k * 0.69314718055994530942;
+        }
+
+        /// @brief resistance of the NTC for a raw 12 bit ADC code
+        constexpr double resistance(uint16_t raw, double R1, Divider divider) {
+            // code 0 and 4095 mean open or shorted NTC, clamp to keep the math finite
+            if (raw < 1) { raw = 1; }
+            if (raw > 4094) { raw = 4094; }
+
+            if (divider == Divider::NTC_LOW) {
+                return R1 * raw / (4096. - raw);
+            }
+            return R1 * (4096. - raw) / raw;
+        }
+
+        /// @brief beta equation, reference for the tables
+        /// @return temperature in C
+        constexpr double beta_celsius(uint16_t raw, double R0, double R1, double beta, Divider divider) {
+            double T = 1. / ((1. / (25 + 273.15)) + (1. / beta) * ln(resistance(raw, R1, divider) / R0));
+            return T - 273.15;
+        }
+    }
+
+    /// @brief piecewise-linear ADC code -> centi-degree table built at compile time from thermistor parameters
+    /// @tparam R0 base resistance of thermistor at T0 (25C) in Ohm
+    /// @tparam R1 resistance of the fixed divider resistor in Ohm
+    /// @tparam Beta the beta coefficient
+    /// @tparam D divider topology
+    template <uint32_t R0, uint32_t R1, uint32_t Beta, Divider D = Divider::NTC_LOW>
+    class ThermistorTable {
+    public:
+        static constexpr uint16_t STEP = 1 << THERMISTOR_TABLE_STEP_BITS;
+        static constexpr uint16_t KNOTS = (4096 >> THERMISTOR_TABLE_STEP_BITS) + 1;
+
+        struct Knots {
+            int16_t centi[KNOTS];
+        };
+
+    private:
+        static constexpr int16_t to_centi(double celsius) {
+            double centi = celsius * 100.;
+            if (centi > 32767.) { return 32767; }
+            if (centi < -32768.) { return -32768; }
+            return (int16_t)(centi < 0 ? centi - .5 : centi + .5);
+        }
+
+        static constexpr Knots build() {
+            Knots knots = {};
+            for (uint16_t i = 0; i < KNOTS; i++) {
+                uint32_t raw = (uint32_t)i * STEP;
+                if (raw > 4095) { raw = 4095; }
+                knots.centi[i] = to_centi(thermistor_math::beta_celsius(raw, R0, R1, Beta, D));
+            }
+            return knots;
+        }
+
+        static constexpr int32_t interpolate(const Knots& knots, uint16_t raw) {
+            uint16_t i = raw >> THERMISTOR_TABLE_STEP_BITS;
+            int32_t fraction = raw & (STEP - 1);
+            int32_t a = knots.centi[i];
+            int32_t b = knots.centi[i + 1];
+            return a + (((b - a) * fraction) >> THERMISTOR_TABLE_STEP_BITS);
+        }
+
+    public:
+        static constexpr Knots knots = build();
+
+        /// @brief worst difference between the table and the beta equation in centi-degrees,
+        /// only codes between THERMISTOR_TABLE_MIN_CELSIUS & THERMISTOR_TABLE_MAX_CELSIUS are considered
+        static constexpr int32_t max_error_centi() {
+            double worst = 0.;
+            for (uint16_t raw = 0; raw < 4096; raw++) {
+                double reference = thermistor_math::beta_celsius(raw, R0, R1, Beta, D);
+                if (reference < THERMISTOR_TABLE_MIN_CELSIUS || reference > THERMISTOR_TABLE_MAX_CELSIUS) { continue; }
+
+                double error = interpolate(knots, raw) - reference * 100.;
+                if (error < 0) { error = -error; }
+                if (error > worst) { worst = error; }
+            }
+            return (int32_t)worst + 1;
+        }
+
+        /// @brief map raw 12 bit ADC code to temperature, integer only
+        /// @return temperature in centi-degrees C
+        static int32_t centi_celsius(uint16_t raw) {
+            static_assert(max_error_centi() <= THERMISTOR_TABLE_MAX_ERROR_CENTI,
+                "thermistor table is not accurate enough, lower THERMISTOR_TABLE_STEP_BITS");
+
+            if (raw > 4095) { raw = 4095; }
+            return interpolate(knots, raw);
+        }
+    };
+}
@@ -0,0 +1,153 @@
+#include "flash_log.h"
+
+#include <string.h>
+
+#include "pico/multicore.h"
+#include "hardware/sync.h"
+
+using namespace telemetry;
+
+static_assert(FLASH_SECTOR_SIZE % FLASH_PAGE_SIZE == 0 && FLASH_PAGE_SIZE % sizeof(TelemetryRecord) == 0,
+    "records have to fill pages & sectors exactly");
+static_assert(FLASH_LOG_SECTORS <= 256, "sector index is 8 bits");
+static_assert(FLASH_LOG_BATCH >= FLASH_LOG_PAGE_SLOTS, "batch has to hold a page");
+
+// core 1 runs from flash as well, it's parked in RAM until the operation is done
+static void flash_erase(uint32_t offset) {
+    multicore_lockout_start_blocking();
+    uint32_t interrupts = save_and_disable_interrupts();
+    flash_range_erase(offset, FLASH_SECTOR_SIZE);
+    restore_interrupts(interrupts);
+    multicore_lockout_end_blocking();
+}
+
+static void flash_program(uint32_t offset, const uint8_t* page) {
+    multicore_lockout_start_blocking();
+    uint32_t interrupts = save_and_disable_interrupts();
+    flash_range_program(offset, page, FLASH_PAGE_SIZE);
+    restore_interrupts(interrupts);
+    multicore_lockout_end_blocking();
+}
+
+FlashLog::FlashLog() {
+    batch_count = 0;
+    sector = FLASH_LOG_SECTORS - 1;
+    slot = FLASH_LOG_SLOTS;
+    sector_sequence = 0;
+    next_erased = false;
+    next_erase_count = 1;
+    next_seq = 0;
+    dropped = 0;
+}
+
+const uint8_t* FlashLog::sector_data(uint8_t sector) {
+    return (const uint8_t*)(XIP_BASE + FLASH_LOG_OFFSET + sector * FLASH_SECTOR_SIZE);
+}
+
+bool FlashLog::is_blank(uint8_t sector) {
+    const uint32_t* words = (const uint32_t*)sector_data(sector);
+    for (uint32_t i = 0; i < FLASH_SECTOR_SIZE / sizeof(uint32_t); i++) {
+        if (words[i] != 0xFFFFFFFF) { return false; }
+    }
+    return true;
+}
+
+void FlashLog::begin() {
+    const FlashLogHeader* newest = nullptr;
+    for (uint8_t candidate = 0; candidate < FLASH_LOG_SECTORS; candidate++) {
+        const FlashLogHeader* header = (const FlashLogHeader*)sector_data(candidate);
+        if (header->magic != FLASH_LOG_MAGIC) { continue; }
+        if (newest == nullptr || header->sequence > newest->sequence) {
+            newest = header;
+            sector = candidate;
+        }
+    }
+
+    // empty region, first commit takes sector 0
+    if (newest == nullptr) {
+        sector = FLASH_LOG_SECTORS - 1;
+        slot = FLASH_LOG_SLOTS;
+        next_erased = is_blank(next_sector());
+        return;
+    }
+
+    sector_sequence = newest->sequence;
+    const TelemetryRecord* records = (const TelemetryRecord*)sector_data(sector);
+    slot = 1;
+    while (slot < FLASH_LOG_SLOTS && records[slot].seq != 0xFFFFFFFF) { slot++; }
+    next_seq = slot > 1 ? records[slot - 1].seq + 1 : newest->first_seq;
+
+    next_erased = is_blank(next_sector());
+    // header of an erased sector is gone, sectors are taken in turn so it was erased as often as this one
+    next_erase_count = newest->erase_count;
+}
+
+bool FlashLog::append(RecordType type, uint8_t index, int16_t value16, int32_t value) {
+    if (batch_count >= FLASH_LOG_BATCH) {
+        dropped++;
+        return false;
+    }
+
+    batch[batch_count++] = { next_seq++, (uint32_t)(time_us_64() / 1000), type, index, value16, value };
+    return true;
+}
+
+void FlashLog::erase_next() {
+    const FlashLogHeader* old = (const FlashLogHeader*)sector_data(next_sector());
+    next_erase_count = old->magic == FLASH_LOG_MAGIC ? old->erase_count + 1 : 1;
+
+    flash_erase(FLASH_LOG_OFFSET + next_sector() * FLASH_SECTOR_SIZE);
+    next_erased = true;
+}
+
+void FlashLog::program() {
+    if (slot >= FLASH_LOG_SLOTS) {
+        sector = next_sector();
+        slot = 0;
+        sector_sequence++;
+        next_erased = false;
+    }
+
+    // bytes left at 0xFF keep what's already in flash, so a page is written in several parts
+    uint8_t page[FLASH_PAGE_SIZE];
+    memset(page, 0xFF, sizeof(page));
+    TelemetryRecord* slots = (TelemetryRecord*)page;
+    uint16_t page_start = slot - slot % FLASH_LOG_PAGE_SLOTS;
+
+    if (slot == 0) {
+        FlashLogHeader header = { FLASH_LOG_MAGIC, sector_sequence, next_erase_count, batch[0].seq };
+        memcpy(&slots[0], &header, sizeof(header));
+        slot = 1;
+    }
+
+    uint8_t count = 0;
+    while (count < batch_count && slot < page_start + FLASH_LOG_PAGE_SLOTS) {
+        slots[slot - page_start] = batch[count++];
+        slot++;
+    }
+
+    flash_program(FLASH_LOG_OFFSET + sector * FLASH_SECTOR_SIZE + page_start * sizeof(TelemetryRecord), page);
+
+    batch_count -= count;
+    memmove(batch, batch + count, batch_count * sizeof(TelemetryRecord));
+}
+
+bool FlashLog::commit(uint32_t window_us) {
+    // next sector is erased ahead while there's still room in this one, so the erase can wait for a long window
+    if (!next_erased && slot >= FLASH_LOG_SLOTS / 2) {
+        if (window_us >= FLASH_LOG_ERASE_US) {
+            erase_next();
+            return true;
+        }
+        if (slot >= FLASH_LOG_SLOTS) { return false; }
+    }
+    if (batch_count == 0 || window_us < FLASH_LOG_PROGRAM_US) { return false; }
+
+    // a full page at once wears flash least, a lone record still gets written after a while
+    uint32_t waited_ms = (uint32_t)(time_us_64() / 1000) - batch[0].time_ms;
+    uint16_t page_free = FLASH_LOG_PAGE_SLOTS - slot % FLASH_LOG_PAGE_SLOTS;
+    if (batch_count < page_free && waited_ms < FLASH_LOG_FLUSH_MS) { return false; }
+
+    program();
+    return true;
+}
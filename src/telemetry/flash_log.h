@@ -0,0 +1,90 @@
+#pragma once
+
+#include <stdio.h>
+
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+
+#include "record.h"
+
+// last 64kB of flash are reserved for the log, firmware has to stay below it
+#define FLASH_LOG_SECTORS 16
+#define FLASH_LOG_OFFSET (PICO_FLASH_SIZE_BYTES - FLASH_LOG_SECTORS * FLASH_SECTOR_SIZE)
+// slot 0 of every sector is its header, the rest are records
+#define FLASH_LOG_SLOTS (FLASH_SECTOR_SIZE / sizeof(telemetry::TelemetryRecord))
+#define FLASH_LOG_PAGE_SLOTS (FLASH_PAGE_SIZE / sizeof(telemetry::TelemetryRecord))
+// records waiting in RAM, newer ones are dropped once it's full
+#define FLASH_LOG_BATCH 32
+// pending records are written once a page worth of them is waiting or the oldest waited this long
+#define FLASH_LOG_FLUSH_MS (30 * 1000)
+// flash is stalled this long, XIP included, W25Q16JV typical values with margin
+#define FLASH_LOG_PROGRAM_US 1000
+#define FLASH_LOG_ERASE_US 50000
+#define FLASH_LOG_MAGIC 0x4C425055      // "UPBL"
+
+namespace telemetry {
+    /// @brief first slot of a sector
+    struct FlashLogHeader {
+        uint32_t magic;
+        /// @brief increases with every sector taken into use, newest sector has the highest one
+        uint32_t sequence;
+        /// @brief erases of this sector so far
+        uint32_t erase_count;
+        /// @brief seq of the first record in the sector
+        uint32_t first_seq;
+    };
+    static_assert(sizeof(FlashLogHeader) == sizeof(TelemetryRecord), "header takes one slot");
+
+    /// @brief Append-only ring of records in the reserved flash region. Sectors are taken in turn, so each one
+    /// is erased equally often. Records wait in RAM and are written by commit() only when the caller has time for
+    /// the stall, flash can't be read (no code runs from XIP) while it's programmed or erased.
+    class FlashLog {
+    private:
+        TelemetryRecord batch[FLASH_LOG_BATCH];
+        uint8_t batch_count;
+
+        /// @brief sector written now & its next free slot, FLASH_LOG_SLOTS when it's full
+        uint8_t sector;
+        uint16_t slot;
+        uint32_t sector_sequence;
+        /// @brief next sector is erased & waits for its header
+        bool next_erased;
+        /// @brief erase count to put into the next sector's header
+        uint32_t next_erase_count;
+
+        uint32_t next_seq;
+        uint32_t dropped;
+
+        static const uint8_t* sector_data(uint8_t sector);
+        uint8_t next_sector() const { return (sector + 1) % FLASH_LOG_SECTORS; }
+        static bool is_blank(uint8_t sector);
+
+        void erase_next();
+        /// @brief write pending records up to the end of the current page, takes the next sector if this one is full
+        void program();
+
+    public:
+        FlashLog();
+
+        /// @brief find the newest sector & the end of the log in it, call once before anything is appended
+        void begin();
+
+        /// @brief queue a record, never blocks
+        /// @return false if the batch is full & record was dropped
+        bool append(RecordType type, uint8_t index, int16_t value16, int32_t value);
+
+        /// @brief do one flash operation if it's due & fits the window. Core 1 has to be running & parkable
+        /// (DisplayService::start()), the lockout waits for it forever otherwise
+        /// @param window_us how long the caller can be stalled, e.g. Scheduler::idle_window()
+        /// @return true if flash was written or erased
+        bool commit(uint32_t window_us);
+
+        uint8_t get_pending() const { return batch_count; }
+
+        uint32_t get_dropped() const { return dropped; }
+
+        uint8_t get_sector() const { return sector; }
+
+        uint16_t get_slot() const { return slot; }
+    };
+};
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// type, sequence number, time_us_32
+#define TELEMETRY_HEADER_BYTES 6
+#define TELEMETRY_CRC_BYTES 2
+#define TELEMETRY_MAX_PAYLOAD 96
+// COBS adds one byte per 254, frames are ended by a zero byte
+#define TELEMETRY_MAX_FRAME (TELEMETRY_HEADER_BYTES + TELEMETRY_MAX_PAYLOAD + TELEMETRY_CRC_BYTES + 2)
+
+/// Binary telemetry frames, shared by the firmware and tools/telemetry_receiver.
+///
+/// Frame before encoding, little endian:
+/// | type | seq | time_us_32 (4) | payload | CRC-16/CCITT-FALSE of everything before (2) |
+/// It's COBS encoded so it has no zero bytes and is followed by a single 0x00.
+namespace telemetry {
+    /// @brief payload layouts, values stay the same so old captures can be read
+    enum class FrameType : uint8_t {
+        Adc = 1,        // input mask, n, then n samples of every input in the mask (oldest first, inputs ascending), u16 each
+        Ports = 2,      // n, then n charging_protocols::PortState as raw bytes
+        Timing = 3,     // n, then last execution & start jitter of n scheduler tasks in us, u16 each
+    };
+
+    constexpr uint16_t crc16_update(uint16_t crc, uint8_t byte) {
+        crc ^= (uint16_t)byte << 8;
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+        return crc;
+    }
+
+    /// @brief CRC of every byte value, built at compile time
+    struct Crc16Table {
+        uint16_t values[256];
+
+        constexpr Crc16Table() : values() {
+            for (uint16_t byte = 0; byte < 256; byte++) { values[byte] = crc16_update(0, byte); }
+        }
+    };
+    static constexpr Crc16Table CRC16_TABLE;
+
+    /// @brief CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF)
+    constexpr uint16_t crc16(const uint8_t* data, size_t length, uint16_t crc = 0xFFFF) {
+        for (size_t i = 0; i < length; i++) {
+            crc = (crc << 8) ^ CRC16_TABLE.values[(crc >> 8) ^ data[i]];
+        }
+        return crc;
+    }
+
+    /// @brief consistent overhead byte stuffing, output holds no zero bytes
+    /// @param out at least length + length / 254 + 1 bytes
+    /// @return encoded length, the delimiter isn't added
+    inline size_t cobs_encode(const uint8_t* in, size_t length, uint8_t* out) {
+        size_t code_at = 0;
+        size_t written = 1;
+        uint8_t code = 1;
+
+        for (size_t i = 0; i < length; i++) {
+            if (in[i] != 0) {
+                out[written++] = in[i];
+                code++;
+            }
+            if (in[i] == 0 || code == 0xFF) {
+                out[code_at] = code;
+                code_at = written++;
+                code = 1;
+            }
+        }
+        out[code_at] = code;
+        return written;
+    }
+
+    /// @brief reverse of cobs_encode(), input is a frame without its delimiter
+    /// @param out at least length bytes
+    /// @return decoded length, 0 if input isn't valid COBS
+    inline size_t cobs_decode(const uint8_t* in, size_t length, uint8_t* out) {
+        size_t written = 0;
+        size_t i = 0;
+
+        while (i < length) {
+            uint8_t code = in[i++];
+            if (code == 0 || i + code - 1 > length) { return 0; }
+
+            for (uint8_t n = 1; n < code; n++) {
+                if (in[i] == 0) { return 0; }
+                out[written++] = in[i++];
+            }
+            // last group has no zero after it
+            if (code != 0xFF && i < length) { out[written++] = 0; }
+        }
+        return written;
+    }
+};
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace telemetry {
+    /// @brief what a record holds, values are kept in dumps so only add new ones at the end
+    enum class RecordType : uint8_t {
+        Boot = 1,           // value: 1 if watchdog caused the reboot
+        Temperature = 2,    // value: thermistor, value16: chip, both in centi-degrees
+        PortState = 3,      // index: port, value: charging_protocols::PortState as raw bytes
+        Error = 4,          // value: address of the message, it's looked up in the ELF file
+        Watchdog = 5,       // index: task that ran, value16: task that was late, value: stage of core 0 | core 1 << 8,
+                            // ids are scheduler::Breadcrumb fields, 0xFF if there was none
+    };
+
+    /// @brief fixed-size record, written to flash as it is (little endian)
+    struct TelemetryRecord {
+        /// @brief increases with every record across reboots, 0xFFFFFFFF is an erased slot
+        uint32_t seq;
+        /// @brief time since boot in ms
+        uint32_t time_ms;
+        RecordType type;
+        uint8_t index;
+        int16_t value16;
+        int32_t value;
+    };
+    static_assert(sizeof(TelemetryRecord) == 16, "record size is part of the flash layout");
+};
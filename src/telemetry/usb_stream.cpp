@@ -0,0 +1,127 @@
+#include "usb_stream.h"
+
+#include <string.h>
+
+#include "pico/stdio_usb.h"
+#include "tusb.h"
+
+using namespace telemetry;
+
+static_assert(TELEMETRY_HEADER_BYTES + TELEMETRY_MAX_PAYLOAD + TELEMETRY_CRC_BYTES <= 254,
+    "frame has to stay within one COBS block");
+static constexpr uint8_t CRC16_CHECK[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+static_assert(crc16(CRC16_CHECK, sizeof(CRC16_CHECK)) == 0x29B1, "CRC-16/CCITT-FALSE check value");
+
+static void put_u16(uint8_t* out, uint16_t value) {
+    out[0] = value & 0xFF;
+    out[1] = value >> 8;
+}
+
+static uint16_t saturate_u16(uint32_t value) {
+    return value > 0xFFFF ? 0xFFFF : value;
+}
+
+UsbStream::UsbStream() {
+    sequence = 0;
+    sent = 0;
+    dropped = 0;
+}
+
+void UsbStream::begin() {
+    // printf() would mix text into the frames
+    stdio_set_driver_enabled(&stdio_usb, false);
+}
+
+bool UsbStream::is_connected() const {
+    return tud_cdc_connected();
+}
+
+bool UsbStream::send(FrameType type, uint8_t length) {
+    if (!is_connected()) { return false; }
+
+    uint32_t time = time_us_32();
+    frame[0] = (uint8_t)type;
+    frame[1] = sequence++;
+    memcpy(&frame[2], &time, sizeof(time));
+
+    uint8_t crc_at = TELEMETRY_HEADER_BYTES + length;
+    uint16_t crc = crc16(frame, crc_at);
+    put_u16(&frame[crc_at], crc);
+
+    size_t encoded_length = cobs_encode(frame, crc_at + TELEMETRY_CRC_BYTES, encoded);
+    encoded[encoded_length++] = 0;
+
+    // out_chars() waits for space, so it's only called when the frame fits as a whole
+    if (tud_cdc_write_available() < encoded_length) {
+        dropped++;
+        return false;
+    }
+    stdio_usb.out_chars((const char*)encoded, encoded_length);
+    sent++;
+    return true;
+}
+
+bool UsbStream::send_adc(const sensors::AdcSampler& sampler, uint8_t count) {
+    uint8_t mask = 0;
+    uint8_t inputs = 0;
+    for (uint8_t input = 0; input < ADC_SAMPLER_MAX_CHANNELS; input++) {
+        if (sampler.is_sampled(input)) {
+            mask |= 1 << input;
+            inputs++;
+        }
+    }
+    if (inputs == 0) { return false; }
+
+    uint8_t max_count = (TELEMETRY_MAX_PAYLOAD - 2) / (inputs * sizeof(uint16_t));
+    if (count > max_count) { count = max_count; }
+    if (count > ADC_SAMPLER_DEPTH - 2) { count = ADC_SAMPLER_DEPTH - 2; }
+
+    // window() is newest first, frame is oldest first with inputs interleaved
+    uint16_t samples[ADC_SAMPLER_MAX_CHANNELS][ADC_SAMPLER_DEPTH];
+    uint8_t slot = 0;
+    for (uint8_t input = 0; input < ADC_SAMPLER_MAX_CHANNELS; input++) {
+        if (!(mask & (1 << input))) { continue; }
+        uint16_t copied = sampler.window(input, samples[slot], count);
+        if (copied < count) { count = copied; }
+        slot++;
+    }
+
+    uint8_t* out = payload();
+    out[0] = mask;
+    out[1] = count;
+    uint8_t length = 2;
+    for (uint8_t n = count; n > 0; n--) {
+        for (slot = 0; slot < inputs; slot++) {
+            put_u16(&out[length], samples[slot][n - 1]);
+            length += sizeof(uint16_t);
+        }
+    }
+    return send(FrameType::Adc, length);
+}
+
+bool UsbStream::send_ports(const charging_protocols::PortState* ports, uint8_t count) {
+    const uint8_t max_count = (TELEMETRY_MAX_PAYLOAD - 1) / sizeof(charging_protocols::PortState);
+    if (count > max_count) { count = max_count; }
+
+    uint8_t* out = payload();
+    out[0] = count;
+    memcpy(&out[1], ports, count * sizeof(charging_protocols::PortState));
+    return send(FrameType::Ports, 1 + count * sizeof(charging_protocols::PortState));
+}
+
+bool UsbStream::send_timing(const scheduler::Scheduler& tasks, uint8_t count) {
+    const uint8_t max_count = (TELEMETRY_MAX_PAYLOAD - 1) / (2 * sizeof(uint16_t));
+    if (count > tasks.get_task_count()) { count = tasks.get_task_count(); }
+    if (count > max_count) { count = max_count; }
+
+    uint8_t* out = payload();
+    out[0] = count;
+    uint8_t length = 1;
+    for (uint8_t id = 0; id < count; id++) {
+        const scheduler::TaskStats& stats = tasks.get_stats(id);
+        put_u16(&out[length], saturate_u16(stats.last_exec_us));
+        put_u16(&out[length + 2], saturate_u16(stats.last_jitter_us));
+        length += 2 * sizeof(uint16_t);
+    }
+    return send(FrameType::Timing, length);
+}
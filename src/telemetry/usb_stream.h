@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdio.h>
+
+#include "pico/stdlib.h"
+
+#include "frame.h"
+#include "../sensors/adc_sampler.h"
+#include "../charging_protocols/port_state.h"
+#include "../scheduler/scheduler.h"
+
+namespace telemetry {
+    /// @brief Binary frames (frame.h) on the USB CDC port, text console stays on UART. A frame is only queued when
+    /// the whole of it fits into the CDC buffer, else it's dropped, so a slow or absent host never stalls a task.
+    /// Dropped frames still take a sequence number so the receiver sees the gap.
+    class UsbStream {
+    private:
+        uint8_t sequence;
+        uint32_t sent;
+        uint32_t dropped;
+
+        /// @brief frame is built here, header first, CRC is appended after the payload
+        uint8_t frame[TELEMETRY_HEADER_BYTES + TELEMETRY_MAX_PAYLOAD + TELEMETRY_CRC_BYTES];
+        uint8_t encoded[TELEMETRY_MAX_FRAME];
+
+        uint8_t* payload() { return &frame[TELEMETRY_HEADER_BYTES]; }
+
+        /// @brief add header & CRC to payload(), encode it and queue it if there's space
+        /// @return false if the frame was dropped
+        bool send(FrameType type, uint8_t length);
+
+    public:
+        UsbStream();
+
+        /// @brief take USB CDC out of stdio, call after stdio_init_all()
+        void begin();
+
+        /// @brief host has the port open
+        bool is_connected() const;
+
+        /// @brief newest samples of every input the sampler has enabled
+        /// @param count samples per input, limited by the payload size & sampler depth
+        bool send_adc(const sensors::AdcSampler& sampler, uint8_t count);
+
+        bool send_ports(const charging_protocols::PortState* ports, uint8_t count);
+
+        /// @brief last execution time & start jitter of the first count tasks
+        bool send_timing(const scheduler::Scheduler& tasks, uint8_t count);
+
+        uint32_t get_sent() const { return sent; }
+
+        uint32_t get_dropped() const { return dropped; }
+    };
+};
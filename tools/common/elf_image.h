@@ -0,0 +1,85 @@
+// Firmware ELF file loaded by host tools, strings (log formats, messages) are looked up by their address on the target.
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <vector>
+
+static inline uint32_t read_u32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline uint16_t read_u16(const uint8_t* p) {
+    return p[0] | (p[1] << 8);
+}
+
+static inline bool load_file(const char* path, std::vector<uint8_t>& out) {
+    FILE* f = fopen(path, "rb");
+    if (f == nullptr) { return false; }
+
+    uint8_t chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) {
+        out.insert(out.end(), chunk, chunk + n);
+    }
+    fclose(f);
+    return true;
+}
+
+class ElfImage {
+private:
+    struct Section {
+        uint32_t address;
+        uint32_t offset;
+        uint32_t size;
+    };
+
+    std::vector<uint8_t> elf;
+    std::vector<Section> sections;
+
+    /// @brief collect sections that have content in the file (32 bit little endian ELF)
+    bool load_sections() {
+        if (elf.size() < 52 || memcmp(elf.data(), "\x7f" "ELF", 4) != 0 || elf[4] != 1 || elf[5] != 1) {
+            return false;
+        }
+
+        uint32_t sh_offset = read_u32(&elf[32]);
+        uint16_t sh_entsize = read_u16(&elf[46]);
+        uint16_t sh_count = read_u16(&elf[48]);
+
+        for (uint16_t i = 0; i < sh_count; i++) {
+            size_t base = sh_offset + (size_t)i * sh_entsize;
+            if (base + 40 > elf.size()) { return false; }
+
+            uint32_t type = read_u32(&elf[base + 4]);
+            uint32_t address = read_u32(&elf[base + 12]);
+            uint32_t offset = read_u32(&elf[base + 16]);
+            uint32_t size = read_u32(&elf[base + 20]);
+            // SHT_NOBITS has no content
+            if (type == 8 || address == 0 || size == 0) { continue; }
+
+            sections.push_back({ address, offset, size });
+        }
+        return true;
+    }
+
+public:
+    /// @return false if the file can't be read or isn't a 32 bit little endian ELF file
+    bool load(const char* path) {
+        return load_file(path, elf) && load_sections();
+    }
+
+    /// @brief string at a target address, nullptr if it isn't in the image
+    const char* string_at(uint32_t address) const {
+        for (const Section& s : sections) {
+            if (address >= s.address && address < s.address + s.size) {
+                size_t at = s.offset + (address - s.address);
+                if (at >= elf.size()) { return nullptr; }
+                return (const char*)&elf[at];
+            }
+        }
+        return nullptr;
+    }
+};
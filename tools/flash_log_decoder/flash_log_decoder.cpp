@@ -0,0 +1,133 @@
+// Prints telemetry records (src/telemetry/flash_log.h) from a flash dump, oldest first.
+// Dump can be the log region or the whole flash, the log is in its last FLASH_LOG_SECTORS sectors, e.g.
+//   picotool save -r 0x101F0000 0x10200000 log.bin
+// Error messages are looked up in the firmware ELF file if it's given.
+//
+// usage: flash_log_decoder <dump.bin> [firmware.elf]
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "../common/elf_image.h"
+#include "../../src/charging_protocols/charging_modes.h"
+#include "../../src/telemetry/record.h"
+
+// same as the firmware, see src/telemetry/flash_log.h
+#define FLASH_SECTOR_SIZE   4096
+#define FLASH_LOG_SECTORS   16
+#define FLASH_LOG_MAGIC     0x4C425055
+#define RECORD_SIZE         sizeof(telemetry::TelemetryRecord)
+
+using namespace telemetry;
+
+struct Sector {
+    uint32_t index;
+    uint32_t sequence;
+    uint32_t erase_count;
+    const uint8_t* data;
+};
+
+static void print_centi(int32_t centi) {
+    printf("%s%d.%02dC", centi < 0 ? "-" : "", (int)(centi < 0 ? -centi : centi) / 100, (int)(centi < 0 ? -centi : centi) % 100);
+}
+
+// 0xFF marks a breadcrumb that wasn't left
+static int breadcrumb(uint32_t id) {
+    return id == 0xFF ? -1 : (int)id;
+}
+
+static void print_record(const uint8_t* raw, const ElfImage* image) {
+    uint32_t seq = read_u32(&raw[0]);
+    uint32_t time_ms = read_u32(&raw[4]);
+    RecordType type = (RecordType)raw[8];
+    uint8_t index = raw[9];
+    int16_t value16 = (int16_t)read_u16(&raw[10]);
+    uint32_t value = read_u32(&raw[12]);
+
+    printf("%8u [%6u.%03u] ", seq, time_ms / 1000, time_ms % 1000);
+    switch (type) {
+    case RecordType::Boot:
+        printf("boot%s\n", value ? " after watchdog reset" : "");
+        break;
+    case RecordType::Temperature:
+        printf("temperature ");
+        print_centi((int32_t)value);
+        printf(" chip ");
+        print_centi(value16);
+        printf("\n");
+        break;
+    case RecordType::PortState: {
+        // PortState: millivolts (2), mode (1), qc:1 | faults:7
+        uint16_t millivolts = value & 0xFFFF;
+        uint8_t mode = (value >> 16) & 0xFF;
+        uint8_t flags = value >> 24;
+        const char* mode_name = mode <= (uint8_t)ChargingModes::NotConnected ? ChargingModes_string[mode] : "?";
+        printf("port %u %s %umV%s", index, mode_name, millivolts, flags & 1 ? " qc" : "");
+        if (flags >> 1) { printf(" faults 0x%x", flags >> 1); }
+        printf("\n");
+        break;
+    }
+    case RecordType::Watchdog: {
+        // task ids follow registration order in main(), stages are profiler::Stage
+        printf("watchdog reset, task %d late task %d stage %d core 1 stage %d\n",
+            breadcrumb(index), breadcrumb(value16 & 0xFF), breadcrumb(value & 0xFF), breadcrumb((value >> 8) & 0xFF));
+        break;
+    }
+    case RecordType::Error: {
+        const char* msg = image != nullptr ? image->string_at(value) : nullptr;
+        if (msg != nullptr) { printf("error: %s\n", msg); }
+        else { printf("error @0x%08x\n", value); }
+        break;
+    }
+    default:
+        printf("unknown record type %u\n", (unsigned)type);
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <dump.bin> [firmware.elf]\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<uint8_t> dump;
+    const size_t region_size = FLASH_LOG_SECTORS * FLASH_SECTOR_SIZE;
+    if (!load_file(argv[1], dump) || dump.size() < region_size) {
+        fprintf(stderr, "can't read %s or it's smaller than the log region (%zu bytes)\n", argv[1], region_size);
+        return 1;
+    }
+
+    ElfImage image;
+    bool have_image = argc > 2;
+    if (have_image && !image.load(argv[2])) {
+        fprintf(stderr, "can't read 32 bit ELF file %s\n", argv[2]);
+        return 1;
+    }
+
+    const uint8_t* region = dump.data() + dump.size() - region_size;
+    std::vector<Sector> sectors;
+    for (uint32_t index = 0; index < FLASH_LOG_SECTORS; index++) {
+        const uint8_t* data = region + index * FLASH_SECTOR_SIZE;
+        if (read_u32(data) != FLASH_LOG_MAGIC) { continue; }
+        sectors.push_back({ index, read_u32(data + 4), read_u32(data + 8), data });
+    }
+    std::sort(sectors.begin(), sectors.end(), [](const Sector& a, const Sector& b) { return a.sequence < b.sequence; });
+
+    uint32_t records = 0;
+    for (const Sector& sector : sectors) {
+        printf("-- sector %u, sequence %u, erased %u times\n", sector.index, sector.sequence, sector.erase_count);
+        for (uint32_t slot = 1; slot < FLASH_SECTOR_SIZE / RECORD_SIZE; slot++) {
+            const uint8_t* raw = sector.data + slot * RECORD_SIZE;
+            // log continues in the next sector, rest of this one was never written
+            if (read_u32(raw) == 0xFFFFFFFF) { break; }
+            print_record(raw, have_image ? &image : nullptr);
+            records++;
+        }
+    }
+    printf("-- %u records in %zu sectors\n", records, sectors.size());
+    return 0;
+}
@@ -0,0 +1,71 @@
+// Turns pico-ssd1306 fonts by 90 degrees and writes them as SSD1306 page-major atlases (src/display_controller/glyph_atlas.h).
+// It's run by the firmware build, the output is compiled into the firmware.
+//
+// usage: glyph_atlas_gen <output.cpp>
+
+#include <stdio.h>
+#include <stdint.h>
+
+// fonts are pulled through the same headers the firmware uses, pico-sdk parts come from host/mock
+#include "../../pico-ssd1306/textRenderer/TextRenderer.h"
+#include "../../pico-ssd1306/textRenderer/16x32_font.h"
+
+#include "../../src/display_controller/glyph_atlas.h"
+
+using namespace display_controller;
+
+template <uint8_t W, uint8_t H, size_t N>
+static bool write_atlas(FILE* out, const char* name, const unsigned char (&font)[N]) {
+    if (font[0] != W || font[1] != H || N < 2 + GLYPH_ATLAS_CHARS * (W * H) / 8) {
+        fprintf(stderr, "glyph_atlas_gen: unexpected layout of %s\n", name);
+        return false;
+    }
+
+    static GlyphAtlas<W, H> atlas = build_atlas<W, H>(font);
+
+    fprintf(out, "static const uint8_t %s[%u] = {", name, (unsigned)sizeof(atlas.bytes));
+    for (size_t i = 0; i < sizeof(atlas.bytes); i++) {
+        fprintf(out, "%s0x%02x,", i % 16 == 0 ? "\n    " : " ", atlas.bytes[i]);
+    }
+    fprintf(out, "\n};\n\n");
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <output.cpp>\n", argv[0]);
+        return 1;
+    }
+
+    FILE* out = fopen(argv[1], "w");
+    if (out == nullptr) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    fprintf(out, "// generated by tools/glyph_atlas/glyph_atlas_gen from pico-ssd1306 fonts, don't edit\n\n");
+    fprintf(out, "#include \"display_controller/glyph_atlas.h\"\n\n");
+    fprintf(out, "using namespace display_controller;\n\n");
+
+    bool ok = write_atlas<5, 8>(out, "atlas_5x8", font_5x8)
+        && write_atlas<8, 8>(out, "atlas_8x8", font_8x8)
+        && write_atlas<12, 16>(out, "atlas_12x16", font_12x16)
+        && write_atlas<16, 32>(out, "atlas_16x32", font_16x32);
+
+    if (ok) {
+        fprintf(out, "const RotatedFont display_controller::rotated_fonts[] = {\n");
+        fprintf(out, "    { 5, 8, %u, atlas_5x8 },\n", GlyphAtlas<5, 8>::COLUMN_BYTES);
+        fprintf(out, "    { 8, 8, %u, atlas_8x8 },\n", GlyphAtlas<8, 8>::COLUMN_BYTES);
+        fprintf(out, "    { 12, 16, %u, atlas_12x16 },\n", GlyphAtlas<12, 16>::COLUMN_BYTES);
+        fprintf(out, "    { 16, 32, %u, atlas_16x32 },\n", GlyphAtlas<16, 32>::COLUMN_BYTES);
+        fprintf(out, "};\n\n");
+        fprintf(out, "const uint8_t display_controller::rotated_font_count = 4;\n");
+    }
+
+    fclose(out);
+    if (!ok) {
+        remove(argv[1]);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,182 @@
+// Rebuilds text from binary log records (src/logging/log.h) captured from the UART.
+// Format strings and %s arguments are looked up in the firmware ELF file, printf output comes as text records.
+//
+// usage: log_decoder <firmware.elf> [capture.bin]   (capture is read from stdin if omitted)
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <string>
+
+#include "../common/elf_image.h"
+
+#define LOG_SYNC_BYTE       0xA5
+#define LOG_HEADER_BYTES    4
+#define LOG_MAX_ARG_WORDS   16
+#define LOG_TEXT            0x80
+
+static ElfImage image;
+
+/// @brief printf on the host with argument words from the device (32 bit int, long & pointer, float for doubles)
+static std::string format(const char* fmt, const uint32_t* words, uint8_t count) {
+    std::string out;
+    uint8_t next = 0;
+    char buffer[256];
+
+    for (const char* p = fmt; *p != '\0'; p++) {
+        if (*p != '%') {
+            out += *p;
+            continue;
+        }
+        if (p[1] == '%') {
+            out += '%';
+            p++;
+            continue;
+        }
+
+        // copy flags, width & precision, count length modifiers
+        std::string spec = "%";
+        p++;
+        while (*p != '\0' && strchr("-+ #0123456789.*", *p)) { spec += *p++; }
+        int longs = 0;
+        while (*p != '\0' && strchr("hlLqjzt", *p)) {
+            if (*p == 'l' || *p == 'q' || *p == 'j') { longs++; }
+            p++;
+        }
+        char conversion = *p;
+        if (conversion == '\0') { break; }
+
+        // only long long integers take two words
+        uint8_t needed = longs >= 2 && strchr("diuxXo", conversion) ? 2 : 1;
+        if (next + needed > count) {
+            out += "<missing>";
+            continue;
+        }
+
+        switch (conversion) {
+        case 'd': case 'i': {
+            if (longs >= 2) {
+                int64_t v = (int64_t)(words[next] | ((uint64_t)words[next + 1] << 32));
+                snprintf(buffer, sizeof(buffer), (spec + "lld").c_str(), (long long)v);
+            }
+            else {
+                snprintf(buffer, sizeof(buffer), (spec + "d").c_str(), (int32_t)words[next]);
+            }
+            break;
+        }
+        case 'u': case 'x': case 'X': case 'o': {
+            if (longs >= 2) {
+                uint64_t v = words[next] | ((uint64_t)words[next + 1] << 32);
+                snprintf(buffer, sizeof(buffer), (spec + "ll" + conversion).c_str(), (unsigned long long)v);
+            }
+            else {
+                snprintf(buffer, sizeof(buffer), (spec + conversion).c_str(), words[next]);
+            }
+            break;
+        }
+        case 'c': {
+            snprintf(buffer, sizeof(buffer), (spec + "c").c_str(), (int)words[next]);
+            break;
+        }
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': {
+            float f;
+            memcpy(&f, &words[next], sizeof(f));
+            snprintf(buffer, sizeof(buffer), (spec + conversion).c_str(), (double)f);
+            break;
+        }
+        case 's': {
+            const char* s = image.string_at(words[next]);
+            if (s != nullptr) {
+                snprintf(buffer, sizeof(buffer), (spec + "s").c_str(), s);
+            }
+            else {
+                snprintf(buffer, sizeof(buffer), "<str@0x%08x>", words[next]);
+            }
+            break;
+        }
+        case 'p': {
+            snprintf(buffer, sizeof(buffer), "0x%08x", words[next]);
+            break;
+        }
+        default:
+            snprintf(buffer, sizeof(buffer), "<%%%c?>", conversion);
+            needed = 0;
+        }
+        next += needed;
+        out += buffer;
+    }
+    return out;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <firmware.elf> [capture.bin]\n", argv[0]);
+        return 1;
+    }
+    if (!image.load(argv[1])) {
+        fprintf(stderr, "can't read 32 bit ELF file %s\n", argv[1]);
+        return 1;
+    }
+
+    FILE* in = argc > 2 ? fopen(argv[2], "rb") : stdin;
+    if (in == nullptr) {
+        fprintf(stderr, "can't open %s\n", argv[2]);
+        return 1;
+    }
+
+    static const char level_names[] = "-EWID";
+    int expected_sequence = -1;
+    int c;
+    while ((c = fgetc(in)) != EOF) {
+        // only output from before logging::init() is outside records
+        if (c != LOG_SYNC_BYTE) {
+            putchar(c);
+            continue;
+        }
+
+        uint8_t header[LOG_HEADER_BYTES - 1];
+        if (fread(header, 1, sizeof(header), in) != sizeof(header)) { break; }
+        uint8_t level = header[0];
+        uint8_t count = header[1];
+        uint8_t sequence = header[2];
+        if (level != LOG_TEXT && (count > LOG_MAX_ARG_WORDS || level > 4)) {
+            fprintf(stderr, "corrupted record header, resyncing\n");
+            continue;
+        }
+
+        if (expected_sequence >= 0 && sequence != expected_sequence) {
+            printf("<%d records lost>\n", (uint8_t)(sequence - expected_sequence));
+        }
+        expected_sequence = (uint8_t)(sequence + 1);
+
+        // printf output, count is its length
+        if (level == LOG_TEXT) {
+            char text[256];
+            if (fread(text, 1, count, in) != count) { break; }
+            fwrite(text, 1, count, stdout);
+            continue;
+        }
+
+        uint32_t words[2 + LOG_MAX_ARG_WORDS];
+        uint8_t raw[sizeof(words)];
+        size_t length = (2 + count) * sizeof(uint32_t);
+        if (fread(raw, 1, length, in) != length) { break; }
+        for (uint8_t i = 0; i < 2 + count; i++) { words[i] = read_u32(&raw[i * 4]); }
+
+        const char* fmt = image.string_at(words[0]);
+        uint32_t timestamp = words[1];
+        printf("[%4u.%06u] %c: ", timestamp / 1000000, timestamp % 1000000, level_names[level]);
+        if (fmt == nullptr) {
+            printf("<unknown format @0x%08x>\n", words[0]);
+            continue;
+        }
+
+        std::string text = format(fmt, &words[2], count);
+        fputs(text.c_str(), stdout);
+        if (text.empty() || text.back() != '\n') { putchar('\n'); }
+    }
+
+    if (in != stdin) { fclose(in); }
+    return 0;
+}
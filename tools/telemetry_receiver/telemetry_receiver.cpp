@@ -0,0 +1,218 @@
+// Writes binary telemetry frames (src/telemetry/frame.h) from the USB CDC port into CSV files:
+//   <prefix>_adc.csv      time_us, seq, sample (0 is oldest of the frame), one column per ADC input
+//   <prefix>_ports.csv    time_us, seq, port, mode, millivolts, qc, faults
+//   <prefix>_timing.csv   time_us, seq, task, exec_us, jitter_us
+// Input is a serial device (put into raw mode), a capture file or stdin. Reading a device stops on Ctrl+C,
+// frames with a bad CRC and gaps in the sequence are counted and reported at the end.
+//
+// usage: telemetry_receiver <out_prefix> [device|capture.bin]   (stdin if omitted)
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+
+#include <string>
+#include <vector>
+
+#include "../common/elf_image.h"
+#include "../../src/charging_protocols/charging_modes.h"
+#include "../../src/telemetry/frame.h"
+
+// ADC_SAMPLER_MAX_CHANNELS of the firmware
+#define ADC_INPUTS 5
+#define PORT_STATE_BYTES 4
+
+using namespace telemetry;
+
+static volatile sig_atomic_t stop = 0;
+
+static void on_signal(int) {
+    stop = 1;
+}
+
+struct Outputs {
+    FILE* adc;
+    FILE* ports;
+    FILE* timing;
+};
+
+struct Counters {
+    uint32_t frames;
+    uint32_t bad;
+    uint32_t lost;
+    uint32_t unknown;
+};
+
+static FILE* open_csv(const std::string& path, const char* header) {
+    FILE* file = fopen(path.c_str(), "w");
+    if (file != nullptr) { fprintf(file, "%s\n", header); }
+    return file;
+}
+
+/// @brief 32 bit device time made monotonic, it wraps every ~71 minutes
+static uint64_t unwrap_time(uint32_t time_us) {
+    static bool started = false;
+    static uint32_t last = 0;
+    static uint64_t high = 0;
+
+    if (started && time_us < last) { high += 1ull << 32; }
+    started = true;
+    last = time_us;
+    return high | time_us;
+}
+
+static bool write_adc(const Outputs& out, uint64_t time, uint8_t seq, const uint8_t* payload, size_t length) {
+    if (length < 2) { return false; }
+    uint8_t mask = payload[0];
+    uint8_t count = payload[1];
+    uint8_t inputs = 0;
+    for (uint8_t input = 0; input < ADC_INPUTS; input++) { inputs += (mask >> input) & 1; }
+    if (length != 2 + (size_t)count * inputs * 2) { return false; }
+
+    const uint8_t* sample = &payload[2];
+    for (uint8_t n = 0; n < count; n++) {
+        fprintf(out.adc, "%llu,%u,%u", (unsigned long long)time, seq, n);
+        for (uint8_t input = 0; input < ADC_INPUTS; input++) {
+            if (mask & (1 << input)) {
+                fprintf(out.adc, ",%u", read_u16(sample));
+                sample += 2;
+            }
+            else {
+                fprintf(out.adc, ",");
+            }
+        }
+        fprintf(out.adc, "\n");
+    }
+    return true;
+}
+
+static bool write_ports(const Outputs& out, uint64_t time, uint8_t seq, const uint8_t* payload, size_t length) {
+    if (length < 1 || length != 1 + (size_t)payload[0] * PORT_STATE_BYTES) { return false; }
+
+    for (uint8_t port = 0; port < payload[0]; port++) {
+        // PortState: millivolts (2), mode (1), qc:1 | faults:7
+        const uint8_t* state = &payload[1 + port * PORT_STATE_BYTES];
+        uint8_t mode = state[2];
+        const char* mode_name = mode <= (uint8_t)ChargingModes::NotConnected ? ChargingModes_string[mode] : "?";
+        fprintf(out.ports, "%llu,%u,%u,%s,%u,%u,%u\n", (unsigned long long)time, seq, port, mode_name,
+            read_u16(state), state[3] & 1, state[3] >> 1);
+    }
+    return true;
+}
+
+static bool write_timing(const Outputs& out, uint64_t time, uint8_t seq, const uint8_t* payload, size_t length) {
+    if (length < 1 || length != 1 + (size_t)payload[0] * 4) { return false; }
+
+    for (uint8_t task = 0; task < payload[0]; task++) {
+        const uint8_t* stats = &payload[1 + task * 4];
+        fprintf(out.timing, "%llu,%u,%u,%u,%u\n", (unsigned long long)time, seq, task, read_u16(stats), read_u16(stats + 2));
+    }
+    return true;
+}
+
+/// @brief decode & check one frame without its delimiter
+/// @return false if it isn't valid COBS or its CRC is wrong
+static bool handle_frame(const uint8_t* encoded, size_t length, const Outputs& out, Counters& counters) {
+    static bool synced = false;
+    static uint8_t next_seq = 0;
+
+    uint8_t frame[TELEMETRY_MAX_FRAME];
+    if (length == 0 || length > sizeof(frame)) { return false; }
+    size_t decoded = cobs_decode(encoded, length, frame);
+    if (decoded < TELEMETRY_HEADER_BYTES + TELEMETRY_CRC_BYTES ||
+        crc16(frame, decoded - TELEMETRY_CRC_BYTES) != read_u16(&frame[decoded - TELEMETRY_CRC_BYTES])) {
+        return false;
+    }
+
+    uint8_t seq = frame[1];
+    if (synced) { counters.lost += (uint8_t)(seq - next_seq); }
+    synced = true;
+    next_seq = seq + 1;
+    counters.frames++;
+
+    uint64_t time = unwrap_time(read_u32(&frame[2]));
+    const uint8_t* payload = &frame[TELEMETRY_HEADER_BYTES];
+    size_t payload_length = decoded - TELEMETRY_HEADER_BYTES - TELEMETRY_CRC_BYTES;
+    bool known = false;
+    switch ((FrameType)frame[0]) {
+    case FrameType::Adc: known = write_adc(out, time, seq, payload, payload_length); break;
+    case FrameType::Ports: known = write_ports(out, time, seq, payload, payload_length); break;
+    case FrameType::Timing: known = write_timing(out, time, seq, payload, payload_length); break;
+    }
+    if (!known) { counters.unknown++; }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <out_prefix> [device|capture.bin]\n", argv[0]);
+        return 1;
+    }
+
+    int fd = argc > 2 ? open(argv[2], O_RDONLY | O_NOCTTY) : STDIN_FILENO;
+    if (fd < 0) {
+        fprintf(stderr, "can't open %s\n", argv[2]);
+        return 1;
+    }
+    // CDC ignores the baud rate, raw mode keeps the tty from eating or translating bytes
+    if (isatty(fd)) {
+        struct termios tty;
+        if (tcgetattr(fd, &tty) == 0) {
+            cfmakeraw(&tty);
+            tcsetattr(fd, TCSANOW, &tty);
+        }
+    }
+
+    std::string prefix = argv[1];
+    Outputs out = {
+        open_csv(prefix + "_adc.csv", "time_us,seq,sample,adc0,adc1,adc2,adc3,adc4"),
+        open_csv(prefix + "_ports.csv", "time_us,seq,port,mode,millivolts,qc,faults"),
+        open_csv(prefix + "_timing.csv", "time_us,seq,task,exec_us,jitter_us"),
+    };
+    if (out.adc == nullptr || out.ports == nullptr || out.timing == nullptr) {
+        fprintf(stderr, "can't create CSV files %s_*.csv\n", prefix.c_str());
+        return 1;
+    }
+
+    // read() returns on Ctrl+C instead of being restarted
+    struct sigaction action = {};
+    action.sa_handler = on_signal;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+
+    Counters counters = {};
+    std::vector<uint8_t> pending;
+    // bytes before the first delimiter can be the tail of a frame sent before the port was opened
+    bool first = true;
+    uint8_t buffer[4096];
+    while (!stop) {
+        ssize_t count = read(fd, buffer, sizeof(buffer));
+        if (count <= 0) { break; }
+
+        for (ssize_t i = 0; i < count; i++) {
+            if (buffer[i] != 0) {
+                pending.push_back(buffer[i]);
+                continue;
+            }
+            if (!pending.empty() && !handle_frame(pending.data(), pending.size(), out, counters) && !first) {
+                counters.bad++;
+            }
+            first = false;
+            pending.clear();
+        }
+        fflush(out.adc);
+        fflush(out.ports);
+        fflush(out.timing);
+    }
+
+    fprintf(stderr, "%u frames, %u lost, %u bad, %u unknown\n", counters.frames, counters.lost, counters.bad, counters.unknown);
+    fclose(out.adc);
+    fclose(out.ports);
+    fclose(out.timing);
+    if (fd != STDIN_FILENO) { close(fd); }
+    return 0;
+}